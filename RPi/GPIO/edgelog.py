@@ -0,0 +1,90 @@
+"""
+Copyright (c) 2020 GC2
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+of the Software, and to permit persons to whom the Software is furnished to do
+so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+"""
+
+# Reader for the edge logs written by RPi.GPIO.start_recording()
+#
+#     from RPi.GPIO import edgelog
+#     for timestamp, gpio, level in edgelog.EdgeLog('edges.log'):
+#         ...
+#
+# timestamp is in ns from CLOCK_MONOTONIC (see EdgeLog.wall_time()) and gpio
+# is the BCM GPIO number whichever numbering mode was used for recording.
+# Run as a script to print a log: python -m RPi.GPIO.edgelog edges.log
+
+import struct
+import sys
+
+MAGIC = b'GPIOLOG1'
+HEADER = struct.Struct('=8sIIQQqB23x')
+RECORD = struct.Struct('=QII')
+
+
+class EdgeLog(object):
+    def __init__(self, path):
+        with open(path, 'rb') as f:
+            data = f.read()
+        if len(data) < HEADER.size:
+            raise ValueError('%s is too short to be an edge log' % path)
+        magic, version, record_size, self.capacity, count, self.realtime_offset, closed = HEADER.unpack_from(data)
+        if magic != MAGIC or record_size != RECORD.size:
+            raise ValueError('%s is not an edge log' % path)
+        self._data = data
+        self.count = count
+        if closed:
+            # recording had stopped before the records were read
+            self.first = max(count - self.capacity, 0)
+        else:
+            # the writer may still be running, so take the count again after
+            # reading and drop anything that could have been overwritten
+            # meanwhile - while record latest is being written, the slot of
+            # latest - capacity is already being overwritten
+            with open(path, 'rb') as f:
+                latest = HEADER.unpack(f.read(HEADER.size))[4]
+            self.first = min(max(latest - self.capacity + 1, 0), count)
+        self.lost = self.first
+
+    def __len__(self):
+        return self.count - self.first
+
+    def __iter__(self):
+        for n in range(self.first, self.count):
+            yield RECORD.unpack_from(self._data, HEADER.size + (n % self.capacity) * RECORD.size)
+
+    def wall_time(self, timestamp):
+        """Convert a record timestamp to seconds since the epoch"""
+        return (timestamp + self.realtime_offset) / 1e9
+
+
+def main(argv):
+    if len(argv) != 2:
+        sys.stderr.write('usage: %s <edge log>\n' % argv[0])
+        return 2
+    log = EdgeLog(argv[1])
+    if log.lost:
+        print('# %d older records overwritten' % log.lost)
+    for timestamp, gpio, level in log:
+        print('%.9f %d %d' % (log.wall_time(timestamp), gpio, level))
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main(sys.argv))
@@ -20,6 +20,7 @@ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 SOFTWARE.
 """
 
+import os
 from distutils.core import setup, Extension
 
 classifiers = ['Development Status :: 5 - Production/Stable',
@@ -32,6 +33,9 @@ classifiers = ['Development Status :: 5 - Production/Stable',
                'Topic :: Home Automation',
                'Topic :: System :: Hardware']
 
+# Banana Pi debug messages are compiled in only if RPIGPIO_DEBUG is set for the build
+define_macros = [('BPI_DEBUG', None)] if os.environ.get('RPIGPIO_DEBUG') else []
+
 setup(name             = 'RPi.GPIO',
       version          = '0.7.200708',
       author           = 'Ben Croston, BPi and GC2',
@@ -43,4 +47,4 @@ setup(name             = 'RPi.GPIO',
       url              = 'https://github.com/GrazerComputerClub/RPi.GPIO',
       classifiers      = classifiers,
       packages         = ['RPi','RPi.GPIO'],
-      ext_modules      = [Extension('RPi._GPIO', ['source/py_gpio.c', 'source/c_gpio.c', 'source/cpuinfo.c', 'source/event_gpio.c', 'source/soft_pwm.c', 'source/py_pwm.c', 'source/common.c', 'source/constants.c', 'source/c_gpio_bpi.c'])])
+      ext_modules      = [Extension('RPi._GPIO', ['source/py_gpio.c', 'source/c_gpio.c', 'source/cpuinfo.c', 'source/event_gpio.c', 'source/soft_pwm.c', 'source/py_pwm.c', 'source/common.c', 'source/constants.c', 'source/c_gpio_bpi.c', 'source/measure.c', 'source/encoder.c', 'source/py_encoder.c', 'source/soft_spi.c', 'source/py_soft_spi.c', 'source/soft_i2c.c', 'source/py_soft_i2c.c', 'source/onewire.c', 'source/py_onewire.c', 'source/ws2812.c', 'source/dht.c', 'source/bus.c', 'source/py_bus.c', 'source/keypad.c', 'source/py_keypad.c', 'source/stepper.c', 'source/py_stepper.c', 'source/servo.c', 'source/py_servo.c', 'source/recorder.c'], define_macros = define_macros)])
@@ -0,0 +1,117 @@
+/*
+Copyright (c) 2020 GC2
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+of the Software, and to permit persons to whom the Software is furnished to do
+so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <stdlib.h>
+#include "c_gpio.h"
+#include "bus.h"
+
+// returns NULL if out of memory
+struct bus *bus_create(const unsigned int *gpio, int width)
+{
+    struct bus *bus;
+    int i, byte, value, bit;
+
+    if ((bus = calloc(1, sizeof(struct bus))) == NULL)
+        return NULL;
+
+    bus->width = width;
+    for (i=0; i<width; i++) {
+        bus->gpio[i] = gpio[i];
+        bus->mask |= 1ULL << gpio[i];
+    }
+
+    // scatter tables - one per byte of the value
+    for (byte=0; byte<4; byte++)
+        for (value=0; value<256; value++)
+            for (bit=0; bit<8; bit++)
+                if ((value & (1 << bit)) && byte*8 + bit < width)
+                    bus->scatter[byte][value] |= 1ULL << gpio[byte*8 + bit];
+
+    // gather tables - one per byte of the 64 bit level registers
+    for (i=0; i<width; i++)
+        for (value=0; value<256; value++)
+            if (value & (1 << (gpio[i] % 8)))
+                bus->gather[gpio[i] / 8][value] |= 1UL << i;
+
+    return bus;
+}
+
+void bus_destroy(struct bus *bus)
+{
+    free(bus);
+}
+
+static uint64_t scatter(struct bus *bus, uint32_t value)
+{
+    return bus->scatter[0][value & 0xff] |
+           bus->scatter[1][(value >> 8) & 0xff] |
+           bus->scatter[2][(value >> 16) & 0xff] |
+           bus->scatter[3][value >> 24];
+}
+
+void bus_write(struct bus *bus, uint32_t value)
+{
+    uint64_t set = scatter(bus, value);
+
+    output_gpio_mask(set, bus->mask & ~set);
+}
+
+uint32_t bus_read(struct bus *bus)
+{
+    uint64_t level = input_gpio_mask(bus->mask);
+    uint32_t value = 0;
+    int byte;
+
+    for (byte=0; byte<8; byte++)
+        value |= bus->gather[byte][(level >> (byte*8)) & 0xff];
+    return value;
+}
+
+// write count words from buf (1, 2 or 4 bytes each depending on the bus
+// width, little endian), pulsing strobe to its active level after each one.
+// The strobe is asserted setup_ns after the data and held for pulse_ns -
+// without them it only lasts one store (a few tens of ns on a Pi 4)
+void bus_write_many(struct bus *bus, const unsigned char *buf, size_t count, unsigned int strobe, int active, unsigned long setup_ns, unsigned long pulse_ns)
+{
+    uint64_t strobe_mask = 1ULL << strobe;
+    uint64_t assert_set = active ? strobe_mask : 0;
+    uint64_t assert_clr = active ? 0 : strobe_mask;
+    uint32_t value;
+    size_t i;
+
+    for (i=0; i<count; i++) {
+        if (bus->width <= 8) {
+            value = buf[i];
+        } else if (bus->width <= 16) {
+            value = buf[i*2] | (buf[i*2+1] << 8);
+        } else {
+            value = buf[i*4] | (buf[i*4+1] << 8) | (buf[i*4+2] << 16) | ((uint32_t)buf[i*4+3] << 24);
+        }
+        bus_write(bus, value);
+        if (setup_ns)
+            delay_ns(setup_ns);
+        output_gpio_mask(assert_set, assert_clr);
+        if (pulse_ns)
+            delay_ns(pulse_ns);
+        output_gpio_mask(assert_clr, assert_set);
+    }
+}
@@ -0,0 +1,43 @@
+/*
+Copyright (c) 2020 GC2
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+of the Software, and to permit persons to whom the Software is furnished to do
+so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/* Parallel data bus */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define BUS_MAX_WIDTH 32
+
+struct bus
+{
+    int width;
+    unsigned int gpio[BUS_MAX_WIDTH];   // gpio[0] carries the least significant bit
+    uint64_t mask;                      // all bus pins
+    uint64_t scatter[4][256];           // value byte -> pins to set
+    uint32_t gather[8][256];            // level register byte -> value bits
+};
+
+struct bus *bus_create(const unsigned int *gpio, int width);
+void bus_destroy(struct bus *bus);
+void bus_write(struct bus *bus, uint32_t value);
+uint32_t bus_read(struct bus *bus);
+void bus_write_many(struct bus *bus, const unsigned char *buf, size_t count, unsigned int strobe, int active, unsigned long setup_ns, unsigned long pulse_ns);
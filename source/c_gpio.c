@@ -26,6 +26,9 @@ SOFTWARE.
 #include <fcntl.h>
 #include <sys/mman.h>
 #include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <unistd.h>
 #include "c_gpio.h"
 #include "event_gpio.h"
 
@@ -54,10 +57,29 @@ SOFTWARE.
 
 static volatile uint32_t *gpio_map;
 
+// pull, function select and event operations for the SoC found by setup()
+struct soc_ops
+{
+    void (*set_pullupdn)(int gpio, int pud);
+    int (*set_pullupdn_mask)(uint64_t mask, int pud);
+    int readable_pulls;
+    void (*setup_gpio)(int gpio, int direction, int pud);
+    void (*set_direction)(int gpio, int direction);
+    int (*set_direction_mask)(uint64_t mask, int direction);
+    int (*gpio_function)(int gpio);
+    void (*set_event)(int reg, int gpio, int enable);
+    void (*clear_event)(int gpio);
+    int (*eventdetected)(int gpio);
+};
+static const struct soc_ops *soc;
+
+// function select/direction registers are read-modify-write, and the keypad
+// scan thread changes them while Python may be changing other pins
+static pthread_mutex_t fsel_lock = PTHREAD_MUTEX_INITIALIZER;
+
 extern int bpi_found;
 extern int bpi_found_mtk;
-extern int *pinTobcm_BP ;
-extern int bpi_debug;
+extern int bpi_irq_needs_mux;
 
 
 void short_wait(void)
@@ -69,6 +91,258 @@ void short_wait(void)
     }
 }
 
+// nanoseconds since an arbitrary point, not affected by changes to the system time
+unsigned long long monotonic_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned long long)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+// busy wait - for delays too short for the scheduler
+void delay_ns(unsigned long ns)
+{
+    unsigned long long end = monotonic_ns() + ns;
+
+    while (monotonic_ns() < end)
+        ;
+}
+
+// BCM register access
+static void bcm_clear_event(int gpio)
+{
+    int offset = EVENT_DETECT_OFFSET + (gpio/32);
+    int shift = (gpio%32);
+
+    *(gpio_map+offset) |= (1 << shift);
+    short_wait();
+    *(gpio_map+offset) = 0;
+}
+
+static int bcm_eventdetected(int gpio)
+{
+    int offset, value, bit;
+
+    offset = EVENT_DETECT_OFFSET + (gpio/32);
+    bit = (1 << (gpio%32));
+    value = *(gpio_map+offset) & bit;
+    if (value)
+        bcm_clear_event(gpio);
+    return value;
+}
+
+// reg is the first of the RISING/FALLING/HIGH/LOW detect registers
+static void bcm_set_event(int reg, int gpio, int enable)
+{
+    int offset = reg + (gpio/32);
+    int shift = (gpio%32);
+
+    if (enable)
+        *(gpio_map+offset) |= 1 << shift;
+    else
+        *(gpio_map+offset) &= ~(1 << shift);
+    bcm_clear_event(gpio);
+}
+
+static void bcm_set_direction(int gpio, int direction)
+{
+    int offset = FSEL_OFFSET + (gpio/10);
+    int shift = (gpio%10)*3;
+
+    if (direction == OUTPUT)
+        *(gpio_map+offset) = (*(gpio_map+offset) & ~(7<<shift)) | (1<<shift);
+    else  // direction == INPUT
+        *(gpio_map+offset) = (*(gpio_map+offset) & ~(7<<shift));
+}
+
+// one read-modify-write per function select register that has a gpio in mask
+static int bcm_set_direction_mask(uint64_t mask, int direction)
+{
+    uint32_t fsel;
+    int reg, gpio, shift;
+
+    for (reg=0; reg<6; reg++) {
+        if (!((mask >> (reg*10)) & 0x3ff))
+            continue;
+        fsel = *(gpio_map+FSEL_OFFSET+reg);
+        for (gpio=reg*10; gpio<reg*10+10 && gpio<54; gpio++) {
+            if (mask & (1ULL << gpio)) {
+                shift = (gpio%10)*3;
+                fsel &= ~(7<<shift);
+                if (direction == OUTPUT)
+                    fsel |= 1<<shift;
+            }
+        }
+        *(gpio_map+FSEL_OFFSET+reg) = fsel;
+    }
+    return 0;
+}
+
+// Contribution by Eric Ptak <trouch@trouch.com>
+static int bcm_gpio_function(int gpio)
+{
+    int offset = FSEL_OFFSET + (gpio/10);
+    int shift = (gpio%10)*3;
+    int value = *(gpio_map+offset);
+
+    value >>= shift;
+    value &= 7;
+    return value; // 0=input, 1=output, 4=alt0
+}
+
+static void bcm_setup_gpio(int gpio, int direction, int pud)
+{
+    soc->set_pullupdn(gpio, pud);
+    bcm_set_direction(gpio, direction);
+}
+
+// Legacy Pull-up/down method
+static void bcm2835_set_pullupdn(int gpio, int pud)
+{
+    int clk_offset = PULLUPDNCLK_OFFSET + (gpio/32);
+    int shift = (gpio%32);
+
+    if (pud == PUD_DOWN) {
+        *(gpio_map+PULLUPDN_OFFSET) = (*(gpio_map+PULLUPDN_OFFSET) & ~3) | PUD_DOWN;
+    } else if (pud == PUD_UP) {
+        *(gpio_map+PULLUPDN_OFFSET) = (*(gpio_map+PULLUPDN_OFFSET) & ~3) | PUD_UP;
+    } else  { // pud == PUD_OFF
+        *(gpio_map+PULLUPDN_OFFSET) &= ~3;
+    }
+    short_wait();
+    *(gpio_map+clk_offset) = 1 << shift;
+    short_wait();
+    *(gpio_map+PULLUPDN_OFFSET) &= ~3;
+    *(gpio_map+clk_offset) = 0;
+}
+
+// one GPPUD/GPPUDCLK handshake for every gpio in mask
+static int bcm2835_set_pullupdn_mask(uint64_t mask, int pud)
+{
+    if (pud == PUD_DOWN || pud == PUD_UP)
+        *(gpio_map+PULLUPDN_OFFSET) = (*(gpio_map+PULLUPDN_OFFSET) & ~3) | pud;
+    else
+        *(gpio_map+PULLUPDN_OFFSET) &= ~3;
+    short_wait();
+    if ((uint32_t)mask)
+        *(gpio_map+PULLUPDNCLK_OFFSET) = (uint32_t)mask;
+    if (mask >> 32)
+        *(gpio_map+PULLUPDNCLK_OFFSET+1) = (uint32_t)(mask >> 32);
+    short_wait();
+    *(gpio_map+PULLUPDN_OFFSET) &= ~3;
+    *(gpio_map+PULLUPDNCLK_OFFSET) = 0;
+    *(gpio_map+PULLUPDNCLK_OFFSET+1) = 0;
+    return 0;
+}
+
+static unsigned int bcm2711_pull_bits(int pud)
+{
+    switch (pud) {
+        case PUD_UP:   return 1;
+        case PUD_DOWN: return 2;
+        default:       return 0; // switch PUD to OFF for other values
+    }
+}
+
+// Pi 4 Pull-up/down method
+static void bcm2711_set_pullupdn(int gpio, int pud)
+{
+    int pullreg = PULLUPDN_OFFSET_2711_0 + (gpio >> 4);
+    int pullshift = (gpio & 0xf) << 1;
+    unsigned int pullbits;
+
+    pullbits = *(gpio_map + pullreg);
+    pullbits &= ~(3 << pullshift);
+    pullbits |= (bcm2711_pull_bits(pud) << pullshift);
+    *(gpio_map + pullreg) = pullbits;
+}
+
+// one store per pull register that has a gpio in mask
+static int bcm2711_set_pullupdn_mask(uint64_t mask, int pud)
+{
+    unsigned int pull = bcm2711_pull_bits(pud);
+    unsigned int pullbits;
+    int reg, i;
+
+    for (reg=0; reg<4; reg++) {
+        if (!((mask >> (reg*16)) & 0xffff))
+            continue;
+        pullbits = *(gpio_map+PULLUPDN_OFFSET_2711_0+reg);
+        for (i=0; i<16; i++) {
+            if (mask & (1ULL << (reg*16 + i))) {
+                pullbits &= ~(3 << (i*2));
+                pullbits |= pull << (i*2);
+            }
+        }
+        *(gpio_map+PULLUPDN_OFFSET_2711_0+reg) = pullbits;
+    }
+    return 0;
+}
+
+// BPI boards - gpio is a BCM number, the sunxi_* and mtk_* calls map it to
+// the board's own pin
+// edge detection is done through sysfs, so the event operations do nothing
+static void bpi_clear_event(int gpio)
+{
+}
+
+static int bpi_eventdetected(int gpio)
+{
+    return 0;
+}
+
+static void bpi_set_event(int reg, int gpio, int enable)
+{
+}
+
+static int bpi_set_pullupdn_mask(uint64_t mask, int pud)
+{
+    return 1;
+}
+
+static int bpi_set_direction_mask(uint64_t mask, int direction)
+{
+    return 1;
+}
+
+static const struct soc_ops bcm2835_ops = {
+    bcm2835_set_pullupdn, bcm2835_set_pullupdn_mask, 0,
+    bcm_setup_gpio, bcm_set_direction, bcm_set_direction_mask,
+    bcm_gpio_function,
+    bcm_set_event, bcm_clear_event, bcm_eventdetected
+};
+
+static const struct soc_ops bcm2711_ops = {
+    bcm2711_set_pullupdn, bcm2711_set_pullupdn_mask, 1,
+    bcm_setup_gpio, bcm_set_direction, bcm_set_direction_mask,
+    bcm_gpio_function,
+    bcm_set_event, bcm_clear_event, bcm_eventdetected
+};
+
+static const struct soc_ops sunxi_ops = {
+    sunxi_set_pullupdn, bpi_set_pullupdn_mask, 0,
+    sunxi_setup_gpio, sunxi_set_direction, bpi_set_direction_mask,
+    sunxi_gpio_function,
+    bpi_set_event, bpi_clear_event, bpi_eventdetected
+};
+
+static const struct soc_ops mtk_ops = {
+    mtk_set_pullupdn, bpi_set_pullupdn_mask, 0,
+    mtk_setup_gpio, mtk_set_direction, bpi_set_direction_mask,
+    mtk_gpio_function,
+    bpi_set_event, bpi_clear_event, bpi_eventdetected
+};
+
+// the BCM2711 pull registers sit where older SoCs read back "gpio"
+static void bcm_detect(void)
+{
+    if (*(gpio_map+PULLUPDN_OFFSET_2711_3) != 0x6770696f)
+        soc = &bcm2711_ops;
+    else
+        soc = &bcm2835_ops;
+}
+
 int setup(void)
 {
     int mem_fd;
@@ -83,8 +357,10 @@ int setup(void)
 
     if( bpi_found == 1 ) {
        if( bpi_found_mtk == 1){
+            soc = &mtk_ops;
             return mtk_setup();
        }
+       soc = &sunxi_ops;
        return sunxi_setup();
     }
     // try /dev/gpiomem first - this does not require root privs
@@ -93,6 +369,7 @@ int setup(void)
         if ((gpio_map = (uint32_t *)mmap(NULL, BLOCK_SIZE, PROT_READ|PROT_WRITE, MAP_SHARED, mem_fd, 0)) == MAP_FAILED) {
             return SETUP_MMAP_FAIL;
         } else {
+            bcm_detect();
             return SETUP_OK;
         }
     }
@@ -146,186 +423,84 @@ int setup(void)
     if ((gpio_map = (uint32_t *)mmap( (void *)gpio_mem, BLOCK_SIZE, PROT_READ|PROT_WRITE, MAP_SHARED|MAP_FIXED, mem_fd, gpio_base)) == MAP_FAILED)
         return SETUP_MMAP_FAIL;
 
+    bcm_detect();
     return SETUP_OK;
 }
 
 void clear_event_detect(int gpio)
 {
-    int offset = EVENT_DETECT_OFFSET + (gpio/32);
-    int shift = (gpio%32);
-
-    if( bpi_found == 1 ) {
-        return;
-	} 
-    *(gpio_map+offset) |= (1 << shift);
-    short_wait();
-    *(gpio_map+offset) = 0;
+    soc->clear_event(gpio);
 }
 
 int eventdetected(int gpio)
 {
-    int offset, value, bit;
-
-    if( bpi_found == 1 ) {
-        return 0;
-	} 
-    offset = EVENT_DETECT_OFFSET + (gpio/32);
-    bit = (1 << (gpio%32));
-    value = *(gpio_map+offset) & bit;
-    if (value)
-        clear_event_detect(gpio);
-    return value;
+    return soc->eventdetected(gpio);
 }
 
 void set_rising_event(int gpio, int enable)
 {
-    int offset = RISING_ED_OFFSET + (gpio/32);
-    int shift = (gpio%32);
-
-    if( bpi_found == 1 ) {
-        return;
-	} 
-    if (enable)
-        *(gpio_map+offset) |= 1 << shift;
-    else
-        *(gpio_map+offset) &= ~(1 << shift);
-    clear_event_detect(gpio);
+    soc->set_event(RISING_ED_OFFSET, gpio, enable);
 }
 
 void set_falling_event(int gpio, int enable)
 {
-    int offset = FALLING_ED_OFFSET + (gpio/32);
-    int shift = (gpio%32);
-
-    if( bpi_found == 1 ) {
-        return;
-	} 
-    if (enable) {
-        *(gpio_map+offset) |= (1 << shift);
-        *(gpio_map+offset) = (1 << shift);
-    } else {
-        *(gpio_map+offset) &= ~(1 << shift);
-    }
-    clear_event_detect(gpio);
+    soc->set_event(FALLING_ED_OFFSET, gpio, enable);
 }
 
 void set_high_event(int gpio, int enable)
 {
-    int offset = HIGH_DETECT_OFFSET + (gpio/32);
-    int shift = (gpio%32);
-
-    if( bpi_found == 1 ) {
-        return;
-	}
-    if (enable)
-        *(gpio_map+offset) |= (1 << shift);
-    else
-        *(gpio_map+offset) &= ~(1 << shift);
-    clear_event_detect(gpio);
+    soc->set_event(HIGH_DETECT_OFFSET, gpio, enable);
 }
 
 void set_low_event(int gpio, int enable)
 {
-    int offset = LOW_DETECT_OFFSET + (gpio/32);
-    int shift = (gpio%32);
-
-    if( bpi_found == 1 ) {
-        return;
-	} 
-    if (enable)
-        *(gpio_map+offset) |= 1 << shift;
-    else
-        *(gpio_map+offset) &= ~(1 << shift);
-    clear_event_detect(gpio);
+    soc->set_event(LOW_DETECT_OFFSET, gpio, enable);
 }
 
 void set_pullupdn(int gpio, int pud)
 {
-    int clk_offset = PULLUPDNCLK_OFFSET + (gpio/32);
-    int shift = (gpio%32);
+    soc->set_pullupdn(gpio, pud);
+}
 
-    if( bpi_found == 1 ) {
-        gpio = *(pinTobcm_BP + gpio);
-        sunxi_set_pullupdn(gpio, pud);
-	return;
-    }
-    // Check GPIO register
-    int is2711 = *(gpio_map+PULLUPDN_OFFSET_2711_3) != 0x6770696f;
-    if (is2711) {
-        // Pi 4 Pull-up/down method
-        int pullreg = PULLUPDN_OFFSET_2711_0 + (gpio >> 4);
-        int pullshift = (gpio & 0xf) << 1;
-        unsigned int pullbits;
-        unsigned int pull = 0;
-        switch (pud) {
-            case PUD_OFF:  pull = 0; break;
-            case PUD_UP:   pull = 1; break;
-            case PUD_DOWN: pull = 2; break;
-            default:       pull = 0; // switch PUD to OFF for other values
-        }
-        pullbits = *(gpio_map + pullreg);
-        pullbits &= ~(3 << pullshift);
-        pullbits |= (pull << pullshift);
-        *(gpio_map + pullreg) = pullbits;
-    } else {
-        // Legacy Pull-up/down method
-        int clk_offset = PULLUPDNCLK_OFFSET + (gpio/32);
-        int shift = (gpio%32);
-
-        if (pud == PUD_DOWN) {
-            *(gpio_map+PULLUPDN_OFFSET) = (*(gpio_map+PULLUPDN_OFFSET) & ~3) | PUD_DOWN;
-        } else if (pud == PUD_UP) {
-            *(gpio_map+PULLUPDN_OFFSET) = (*(gpio_map+PULLUPDN_OFFSET) & ~3) | PUD_UP;
-        } else  { // pud == PUD_OFF
-            *(gpio_map+PULLUPDN_OFFSET) &= ~3;
-        }
-        short_wait();
-        *(gpio_map+clk_offset) = 1 << shift;
-        short_wait();
-        *(gpio_map+PULLUPDN_OFFSET) &= ~3;
-        *(gpio_map+clk_offset) = 0;
-    }
+// set the same pull up/down on every gpio in mask - one GPPUD/GPPUDCLK
+// handshake for all of them, or one store per pull register on BCM2711
+// returns 1 if not supported on this SoC (use set_pullupdn() instead)
+int set_pullupdn_mask(uint64_t mask, int pud)
+{
+    return soc->set_pullupdn_mask(mask, pud);
 }
 
 void setup_gpio(int gpio, int direction, int pud)
 {
+    pthread_mutex_lock(&fsel_lock);
+    soc->setup_gpio(gpio, direction, pud);
+    pthread_mutex_unlock(&fsel_lock);
+}
 
-    if( bpi_found == 1 ) {
-        gpio = *(pinTobcm_BP + gpio);
-	    if(bpi_found_mtk == 1){
-		    return;
-	    }else{
-		    return sunxi_setup_gpio(gpio, direction, pud);
-	    }
-    }
-    int offset = FSEL_OFFSET + (gpio/10);
-    int shift = (gpio%10)*3;
+// switch between INPUT and OUTPUT without touching the pull up/down
+void set_direction_gpio(int gpio, int direction)
+{
+    pthread_mutex_lock(&fsel_lock);
+    soc->set_direction(gpio, direction);
+    pthread_mutex_unlock(&fsel_lock);
+}
 
-    set_pullupdn(gpio, pud);
-    if (direction == OUTPUT)
-        *(gpio_map+offset) = (*(gpio_map+offset) & ~(7<<shift)) | (1<<shift);
-    else  // direction == INPUT
-        *(gpio_map+offset) = (*(gpio_map+offset) & ~(7<<shift));
+// set the direction of every gpio in mask - each function select register is
+// written at most once.  Pull up/downs are not touched
+// returns 1 if not supported on this SoC (use set_direction_gpio() instead)
+int set_direction_gpio_mask(uint64_t mask, int direction)
+{
+    int result;
+
+    pthread_mutex_lock(&fsel_lock);
+    result = soc->set_direction_mask(mask, direction);
+    pthread_mutex_unlock(&fsel_lock);
+    return result;
 }
 
-// Contribution by Eric Ptak <trouch@trouch.com>
 int gpio_function(int gpio)
 {
-    if( bpi_found == 1 ) {
-       gpio = *(pinTobcm_BP + gpio);
-	    if(bpi_found_mtk == 1){
-		    return 0;
-	    }else{
-		    return sunxi_gpio_function(gpio);
-	    }
-    }
-    int offset = FSEL_OFFSET + (gpio/10);
-    int shift = (gpio%10)*3;
-    int value = *(gpio_map+offset);
-
-    value >>= shift;
-    value &= 7;
-    return value; // 0=input, 1=output, 4=alt0
+    return soc->gpio_function(gpio);
 }
 
 void output_gpio(int gpio, int value)
@@ -333,11 +508,9 @@ void output_gpio(int gpio, int value)
     int offset, shift;
 
     if ( bpi_found == 1)  {
-	    if (bpi_debug>=2) printf("gpio-call = %d\n", gpio);
-	    gpio = *(pinTobcm_BP + gpio);
-	    if (bpi_debug>=2) printf("gpio = %d, value = %d\n", gpio, value);
+	    if (bpi_debug_on(2)) printf("gpio = %d, value = %d\n", gpio, value);
 	    if(bpi_found_mtk ==  1){
-		    mtk_set_gpio_out(gpio, value);
+		    mtk_output_gpio(gpio, value);
 	    }else{
 	       sunxi_output_gpio(gpio, value);
 	    }
@@ -353,22 +526,39 @@ void output_gpio(int gpio, int value)
     *(gpio_map+offset) = 1 << shift;
 }
 
+// A20 - sysfs edge detection switches the pin to its EINT mux function and
+// DAT stops following the pin (see irq_read_needs_mux in the sunxi pinctrl
+// driver), so the level has to come from the sysfs value file
+// returns -1 if edge detection is not active on the pin
+static int sysfs_input_gpio(int gpio)
+{
+   struct gpios *g;
+   char c = 0;
+
+   if (!bpi_irq_needs_mux)
+      return -1;
+   g = get_gpio(gpio);
+   if (g == NULL || g->value_fd <= 0)
+      return -1;
+   if (bpi_debug_on(4)) printf("edge detection active\n");
+   lseek(g->value_fd, 0L, SEEK_SET);
+   if (read(g->value_fd, &c, 1) != 1)
+      return -1;
+   if (bpi_debug_on(2)) printf("input_gpio from sysfs gpio = %d, value = %c\n", gpio, c);
+   return c != '0';
+}
+
 int input_gpio(int gpio)
 {
    int offset, value, mask;
 
    if ( bpi_found == 1)  {
-      char c = 0;
-      struct gpios* gpioEdge = get_gpio(gpio);
-      if (gpioEdge && gpioEdge->value_fd>0) {
-        if (bpi_debug>=4) printf("edge detection active\n");
-        lseek(gpioEdge->value_fd, 0L, SEEK_SET) ;
-        if (read(gpioEdge->value_fd, &c, 1)) {
-          if (bpi_debug>=2) printf("input_gpio from sysfs gpio = %d, value = %c\n", gpio, c);
-          return (c == '0') ? 0 : 1 ;
-        }
-      }
-      gpio = *(pinTobcm_BP + gpio);
+      // the data registers hold the level, except on the A20 while sysfs has
+      // the pin for edge detection
+      if (bpi_found_mtk == 1)
+         return mtk_input_gpio(gpio);
+      if ((value = sysfs_input_gpio(gpio)) >= 0)
+         return value;
       return sunxi_input_gpio(gpio);
    }
    offset = PINLEVEL_OFFSET + (gpio/32);
@@ -377,6 +567,93 @@ int input_gpio(int gpio)
    return value;
 }
 
+// bit n of set/clr is gpio n - one store per register on the Pi, one
+// read-modify-write per output register on BPI boards
+void output_gpio_mask(uint64_t set, uint64_t clr)
+{
+    if (bpi_found == 1) {
+        clr &= ~set;
+        if (bpi_found_mtk == 1)
+            mtk_output_gpio_mask(set, clr);
+        else
+            sunxi_output_gpio_mask(set, clr);
+        return;
+    }
+    if ((uint32_t)set)
+        *(gpio_map+SET_OFFSET) = (uint32_t)set;
+    if (set >> 32)
+        *(gpio_map+SET_OFFSET+1) = (uint32_t)(set >> 32);
+    if ((uint32_t)clr)
+        *(gpio_map+CLR_OFFSET) = (uint32_t)clr;
+    if (clr >> 32)
+        *(gpio_map+CLR_OFFSET+1) = (uint32_t)(clr >> 32);
+}
+
+// returns the levels of the gpios in mask, bit n is gpio n
+uint64_t input_gpio_mask(uint64_t mask)
+{
+    uint64_t value = 0;
+    int gpio, level;
+
+    if (bpi_found == 1) {
+        if (bpi_found_mtk == 1)
+            return mtk_input_gpio_mask(mask);
+        value = sunxi_input_gpio_mask(mask);
+        if (bpi_irq_needs_mux)
+            for (gpio=0; gpio<64; gpio++)
+                if ((mask & (1ULL << gpio)) && (level = sysfs_input_gpio(gpio)) >= 0)
+                    value = (value & ~(1ULL << gpio)) | ((uint64_t)level << gpio);
+        return value;
+    }
+    if ((uint32_t)mask)
+        value = *(gpio_map+PINLEVEL_OFFSET);
+    if (mask >> 32)
+        value |= (uint64_t)*(gpio_map+PINLEVEL_OFFSET+1) << 32;
+    return value & mask;
+}
+
+// read the function selects, levels and (BCM2711) pulls of every gpio
+// returns 1 if the SoC is not supported
+int snapshot_gpio(struct gpio_snapshot *snap)
+{
+    int i;
+
+    if (bpi_found == 1)
+        return 1;
+
+    for (i=0; i<6; i++)
+        snap->fsel[i] = *(gpio_map+FSEL_OFFSET+i);
+    snap->level[0] = *(gpio_map+PINLEVEL_OFFSET);
+    snap->level[1] = *(gpio_map+PINLEVEL_OFFSET+1);
+    snap->has_pull = soc->readable_pulls;
+    for (i=0; i<4; i++)
+        snap->pull[i] = snap->has_pull ? *(gpio_map+PULLUPDN_OFFSET_2711_0+i) : 0;
+    return 0;
+}
+
+// write a snapshot back with one store per register - output latches first so
+// that pins switched back to outputs come up at their saved level
+// the legacy pull registers can't be read, so pulls are only restored on BCM2711
+void restore_gpio(const struct gpio_snapshot *snap)
+{
+    int i;
+
+    if (bpi_found == 1)
+        return;
+
+    *(gpio_map+SET_OFFSET) = snap->level[0];
+    *(gpio_map+SET_OFFSET+1) = snap->level[1];
+    *(gpio_map+CLR_OFFSET) = ~snap->level[0];
+    *(gpio_map+CLR_OFFSET+1) = ~snap->level[1] & 0x003fffff;   // gpios 32-53
+    if (snap->has_pull && soc->readable_pulls)
+        for (i=0; i<4; i++)
+            *(gpio_map+PULLUPDN_OFFSET_2711_0+i) = snap->pull[i];
+    pthread_mutex_lock(&fsel_lock);
+    for (i=0; i<6; i++)
+        *(gpio_map+FSEL_OFFSET+i) = snap->fsel[i];
+    pthread_mutex_unlock(&fsel_lock);
+}
+
 void cleanup(void)
 {
     munmap((void *)gpio_map, BLOCK_SIZE);
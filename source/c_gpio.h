@@ -20,23 +20,68 @@ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 SOFTWARE.
 */
 
+#include <stdint.h>
+
+// register contents saved by snapshot_gpio()
+struct gpio_snapshot
+{
+    uint32_t fsel[6];
+    uint32_t level[2];
+    uint32_t pull[4];   // BCM2711 only
+    uint32_t has_pull;
+};
+
 int setup(void);
 void setup_gpio(int gpio, int direction, int pud);
+int set_pullupdn_mask(uint64_t mask, int pud);
 int gpio_function(int gpio);
 void output_gpio(int gpio, int value);
 int input_gpio(int gpio);
+void set_direction_gpio(int gpio, int direction);
+int set_direction_gpio_mask(uint64_t mask, int direction);
+void output_gpio_mask(uint64_t set, uint64_t clr);
+uint64_t input_gpio_mask(uint64_t mask);
+int snapshot_gpio(struct gpio_snapshot *snap);
+void restore_gpio(const struct gpio_snapshot *snap);
 void set_rising_event(int gpio, int enable);
 void set_falling_event(int gpio, int enable);
 void set_high_event(int gpio, int enable);
 void set_low_event(int gpio, int enable);
 int eventdetected(int gpio);
 void cleanup(void);
+unsigned long long monotonic_ns(void);
+void delay_ns(unsigned long ns);
 
 int sunxi_setup(void);
 void sunxi_setup_gpio(int gpio, int direction, int pud);
+void sunxi_set_pullupdn(int gpio, int pud);
+void sunxi_set_direction(int gpio, int direction);
 int sunxi_gpio_function(int gpio);
 void sunxi_output_gpio(int gpio, int value);
+void sunxi_output_gpio_mask(uint64_t set, uint64_t clr);
 int sunxi_input_gpio(int gpio);
+uint64_t sunxi_input_gpio_mask(uint64_t mask);
+
+int mtk_setup(void);
+void mtk_setup_gpio(int gpio, int direction, int pud);
+void mtk_set_direction(int gpio, int direction);
+void mtk_set_pullupdn(int gpio, int pud);
+void mtk_set_mode(int gpio, int mode);
+int mtk_gpio_function(int gpio);
+void mtk_output_gpio(int gpio, int value);
+int mtk_input_gpio(int gpio);
+void mtk_output_gpio_mask(uint64_t set, uint64_t clr);
+uint64_t mtk_input_gpio_mask(uint64_t mask);
+
+// Banana Pi debug messages are only compiled in when built with BPI_DEBUG
+// (setup.py defines it if RPIGPIO_DEBUG is set), so release builds test
+// nothing on the register paths.  The level is RPIGPIO_DEBUG at run time
+extern int bpi_debug;
+#ifdef BPI_DEBUG
+#define bpi_debug_on(level) (bpi_debug >= (level))
+#else
+#define bpi_debug_on(level) 0
+#endif
 
 #define SETUP_OK           0
 #define SETUP_DEVMEM_FAIL  1
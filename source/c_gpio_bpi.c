@@ -26,6 +26,7 @@ SOFTWARE.
 #include <fcntl.h>
 #include <sys/mman.h>
 #include <string.h>
+#include <unistd.h>
 #include "cpuinfo.h"
 #include "c_gpio.h"
 #include "bpi_gpio.h"
@@ -65,12 +66,10 @@ static volatile uint32_t *gpio_map;
 #define SUNXI_PUD_OFFSET	0x1C
 #define SUNXI_BANK_SIZE		0x24
 
-#define MAP_SIZE        (4096*2)
-#define MAP_MASK        (MAP_SIZE - 1)
-
 #define MTK_GPIO_BASE_ADDR		0x10005000
 #define MTK_GPIO_DIR				0x00
-#define MTK_GPIO_PULLE          		0x150
+#define MTK_GPIO_PULLEN				0x150
+#define MTK_GPIO_PULLSEL			0x280
 #define MTK_GPIO_DOUT				0x500
 #define MTK_GPIO_DIN				0x630
 #define MTK_GPIO_MODE				0x760
@@ -108,8 +107,25 @@ typedef struct sunxi_gpio_reg {
 static volatile uint32_t *pio_map;
 static volatile uint32_t *r_pio_map;
 
+// registers of each BCM numbered gpio, resolved once by sunxi_setup() so
+// that the calls below don't have to work out the bank every time
+struct sunxi_pin
+{
+    volatile uint32_t *cfg;     // CFG word holding the pin
+    volatile uint32_t *dat;
+    volatile uint32_t *pull;    // PULL word holding the pin
+    uint32_t bit;               // pin in dat
+    int cfg_shift;
+    int pull_shift;
+};
+static struct sunxi_pin sunxi_pins[64];
+
+// gpios that are not on the header point here instead of at the PIO block
+static volatile uint32_t sunxi_no_reg;
+
 int bpi_found=-1;
 int bpi_found_mtk = 0;
+int bpi_irq_needs_mux = 0;
 int bpi_debug = 0;
 
 #define BPI_MODEL_MIN   21
@@ -286,64 +302,204 @@ BoardHardwareDeviceTreeInfo gAllBoardHardwareDeviceTreeInfo[] = {
 
 static uint8_t* gpio_mmap_reg = NULL;
 
-int mtk_set_gpio_out(unsigned int pin, unsigned int output)
+// bits to set and clear in one output register, so that a mask of gpios
+// costs one read-modify-write per register
+struct out_word
 {
-    uint32_t tmp;
-    uint8_t* position = NULL;
+    volatile uint32_t *reg;
+    uint32_t set;
+    uint32_t clr;
+};
 
-    position = gpio_mmap_reg + MTK_GPIO_DOUT + (pin / 16) * 16;
-    if (bpi_debug>=2) printf("pin = %d, output = %d, positon = %p\n", pin, output, position);
-    tmp = *(volatile uint32_t*)(position);
-    if (bpi_debug>=4) printf("tmp = %X\n", tmp);
-    if(output == 1){
-	    tmp |= (1u << (pin % 16));
-    }else{
-	    tmp &= ~(1u << (pin % 16));
+// returns the new number of words
+static int out_word_add(struct out_word *words, int n, volatile uint32_t *reg, uint32_t bit, int value)
+{
+    int i;
+
+    for (i=0; i<n && words[i].reg != reg; i++)
+        ;
+    if (i == n) {
+        words[n].reg = reg;
+        words[n].set = words[n].clr = 0;
+        n++;
     }
-    if (bpi_debug>=4) printf("tmp = %X\n", tmp);
-    *(volatile uint32_t*)(position) = tmp;
-    if (bpi_debug>=1) printf("finish mtk_set_gpio_out\n");
-    return 1;
+    if (value)
+        words[i].set |= bit;
+    else
+        words[i].clr |= bit;
+    return n;
+}
 
+static void out_words_write(const struct out_word *words, int n)
+{
+    int i;
+
+    for (i=0; i<n; i++)
+        *words[i].reg = (*words[i].reg & ~words[i].clr) | words[i].set;
 }
 
-int mtk_set_gpio_dir(unsigned int pin, unsigned int dir)
+// input registers already read for a mask of gpios, so each is read once
+struct in_word
 {
-    uint32_t tmp;
-    uint8_t* position = NULL;
+    volatile uint32_t *reg;
+    uint32_t value;
+};
 
-    if(pin < 199){
-        position = gpio_mmap_reg + (pin / 16) * 16;
-    }else{
-        position = gpio_mmap_reg + (pin / 16) * 16 + 0x10;
+static uint32_t in_word_read(struct in_word *words, int *n, volatile uint32_t *reg)
+{
+    int i;
+
+    for (i=0; i<*n && words[i].reg != reg; i++)
+        ;
+    if (i == *n) {
+        words[i].reg = reg;
+        words[i].value = *reg;
+        (*n)++;
     }
-    if (bpi_debug>=2) printf("pin = %d, dir=%d, positon = %p\n", pin, dir, position);
-    tmp = *(volatile uint32_t*)(position);
-    if (bpi_debug>=4) printf("tmp = %X\n", tmp);
-    if(dir == 1){
-        tmp |= (1u << (pin % 16));
-    }else{
-        tmp &= ~(1u << (pin % 16));
+    return words[i].value;
+}
+
+// registers of each BCM numbered gpio, resolved once by mtk_setup()
+struct mtk_pin
+{
+    volatile uint32_t *dir;
+    volatile uint32_t *dout;
+    volatile uint32_t *din;
+    volatile uint32_t *pullen;
+    volatile uint32_t *pullsel;
+    volatile uint32_t *mode;
+    uint32_t bit;               // pin in dir, dout, din, pullen and pullsel
+    int mode_shift;
+};
+static struct mtk_pin mtk_pins[64];
+
+// gpios that are not on the header point here instead of at the GPIO block
+static volatile uint32_t mtk_no_reg;
+
+#define MTK_REG(offset, pin)    ((volatile uint32_t *)(gpio_mmap_reg + (offset) + ((pin) / 16) * 16))
+
+static void mtk_build_pins(void)
+{
+    struct mtk_pin *p;
+    int gpio, pin;
+
+    for (gpio=0; gpio<64; gpio++) {
+        p = &mtk_pins[gpio];
+        pin = pinTobcm_BP ? *(pinTobcm_BP + gpio) : -1;
+        if (pin < 0) {
+            p->dir = p->dout = p->din = p->pullen = p->pullsel = p->mode = &mtk_no_reg;
+            p->bit = 0;
+            p->mode_shift = 0;
+            continue;
+        }
+        p->dir = MTK_REG(MTK_GPIO_DIR + (pin < 199 ? 0 : 0x10), pin);
+        p->dout = MTK_REG(MTK_GPIO_DOUT, pin);
+        p->din = MTK_REG(MTK_GPIO_DIN, pin);
+        p->pullen = MTK_REG(MTK_GPIO_PULLEN, pin);
+        p->pullsel = MTK_REG(MTK_GPIO_PULLSEL, pin);
+        p->mode = (volatile uint32_t *)(gpio_mmap_reg + MTK_GPIO_MODE + (pin / 5) * 16);
+        p->bit = 1u << (pin % 16);
+        p->mode_shift = (pin % 5) * 3;
+        if (bpi_debug_on(2)) printf("gpio(%d) pin(%d) dir(%p)\n", gpio, pin, p->dir);
     }
-    if (bpi_debug>=4) printf("tmp = %X\n", tmp);
-    *(volatile uint32_t*)(position) = tmp;
-    return 0;   
 }
 
-int mtk_set_gpio_mode(unsigned int pin, unsigned int mode){
-    uint32_t tmp;
-    uint8_t* position = NULL;
-    
-    position = gpio_mmap_reg + MTK_GPIO_MODE + (pin / 5) * 16;
-    if (bpi_debug>=2) printf("pin=%d, mode=%d, positon = %p\n", pin, mode, position);
-    tmp = *(volatile uint32_t*)(position);
+// the mtk_* gpio calls take BCM gpio numbers (see mtk_pins)
+void mtk_output_gpio(int gpio, int value)
+{
+    struct mtk_pin *p = &mtk_pins[gpio];
 
-    if (bpi_debug>=4) printf("tmp = %X\n", tmp);
-    tmp &= ~(1u << ((pin % 5) * 3));
-    if (bpi_debug>=4) printf("tmp = %X\n", tmp);
+    if (bpi_debug_on(1)) printf("mtk_output_gpio %d %d\n", gpio, value);
+    if (value)
+        *p->dout |= p->bit;
+    else
+        *p->dout &= ~p->bit;
+}
 
-    *(volatile uint32_t*)(position) = tmp;
-    return 0;
+int mtk_input_gpio(int gpio)
+{
+    struct mtk_pin *p = &mtk_pins[gpio];
+
+    return (*p->din & p->bit) != 0;
+}
+
+// bit n of set/clr is gpio n - one read-modify-write per DOUT word
+void mtk_output_gpio_mask(uint64_t set, uint64_t clr)
+{
+    struct out_word words[64];
+    int n = 0, gpio;
+
+    for (gpio=0; gpio<64; gpio++) {
+        if (!((set | clr) & (1ULL << gpio)) || mtk_pins[gpio].dout == &mtk_no_reg)
+            continue;
+        n = out_word_add(words, n, mtk_pins[gpio].dout, mtk_pins[gpio].bit, (set >> gpio) & 1);
+    }
+    out_words_write(words, n);
+}
+
+// returns the levels of the gpios in mask - each DIN word is read once
+uint64_t mtk_input_gpio_mask(uint64_t mask)
+{
+    struct in_word words[64];
+    uint64_t value = 0;
+    int n = 0, gpio;
+
+    for (gpio=0; gpio<64; gpio++)
+        if ((mask & (1ULL << gpio)) && (in_word_read(words, &n, mtk_pins[gpio].din) & mtk_pins[gpio].bit))
+            value |= 1ULL << gpio;
+    return value;
+}
+
+void mtk_set_direction(int gpio, int direction)
+{
+    struct mtk_pin *p = &mtk_pins[gpio];
+
+    if (bpi_debug_on(2)) printf("mtk_set_direction %d %d\n", gpio, direction);
+    if (direction == OUTPUT)
+        *p->dir |= p->bit;
+    else
+        *p->dir &= ~p->bit;
+}
+
+void mtk_set_pullupdn(int gpio, int pud)
+{
+    struct mtk_pin *p = &mtk_pins[gpio];
+
+    if (bpi_debug_on(2)) printf("mtk_set_pullupdn %d %d\n", gpio, pud);
+    if (pud == PUD_UP)
+        *p->pullsel |= p->bit;
+    else if (pud == PUD_DOWN)
+        *p->pullsel &= ~p->bit;
+    if (pud == PUD_UP || pud == PUD_DOWN)
+        *p->pullen |= p->bit;
+    else
+        *p->pullen &= ~p->bit;
+}
+
+// mode 0 is the gpio function of every pin
+void mtk_set_mode(int gpio, int mode)
+{
+    struct mtk_pin *p = &mtk_pins[gpio];
+
+    *p->mode = (*p->mode & ~(7u << p->mode_shift)) | ((uint32_t)mode << p->mode_shift);
+}
+
+void mtk_setup_gpio(int gpio, int direction, int pud)
+{
+    if (bpi_debug_on(1)) printf("mtk_setup_gpio %d %d %d\n", gpio, direction, pud);
+    mtk_set_pullupdn(gpio, pud);
+    mtk_set_direction(gpio, direction);
+    mtk_set_mode(gpio, 0);
+}
+
+// 0=input, 1=output, 4=any other function (there is no BCM alt numbering here)
+int mtk_gpio_function(int gpio)
+{
+    struct mtk_pin *p = &mtk_pins[gpio];
+
+    if ((*p->mode >> p->mode_shift) & 7)
+        return 4;
+    return (*p->dir & p->bit) ? 1 : 0;
 }
 
 int mtk_setup(void)
@@ -351,7 +507,7 @@ int mtk_setup(void)
     int gpio_mmap_fd = 0;
     if ((gpio_mmap_fd = open("/dev/mem", O_RDWR|O_SYNC)) < 0) {
         fprintf(stderr, "unable to open mmap file");
-        return -1;
+        return SETUP_DEVMEM_FAIL;
     }
     
       gpio_mmap_reg = (uint8_t*)mmap(NULL, 8 * 1024, PROT_READ | PROT_WRITE,
@@ -361,37 +517,66 @@ int mtk_setup(void)
         fprintf(stderr, "failed to mmap");
         gpio_mmap_reg = NULL;
         close(gpio_mmap_fd);
-        return -1;
+        return SETUP_MMAP_FAIL;
     }
-    if (bpi_debug>=1) printf("gpio_mmap_fd=%d, gpio_map=%p", gpio_mmap_fd, gpio_mmap_reg);
+    if (bpi_debug_on(1)) printf("gpio_mmap_fd=%d, gpio_map=%p", gpio_mmap_fd, gpio_mmap_reg);
 
+    mtk_build_pins();
     return SETUP_OK;
 
 }
 
 
-uint32_t sunxi_readl(volatile uint32_t *addr)
+static sunxi_gpio_t *sunxi_bank(int pin)
 {
-    if (bpi_debug>=1) printf("sunxi_readl\n");
-    uint32_t val = 0;
-    uint32_t mmap_base = (uint32_t)addr & (~MAP_MASK);
-    uint32_t mmap_seek = ((uint32_t)addr - mmap_base) >> 2;
-    val = *(gpio_map + mmap_seek);
-    return val;
-}   
+    int bank = GPIO_BANK(pin); //pin >> 5
+
+/* DK, for PL and PM */
+    if(bank >= 11)
+      return r_pio_map ? &((sunxi_gpio_reg_t *) r_pio_map)->gpio_bank[bank - 11] : NULL;
+    return &((sunxi_gpio_reg_t *) pio_map)->gpio_bank[bank];
+}
 
-void sunxi_writel(volatile uint32_t *addr, uint32_t val)
+// 1 if a header pin lives on R_PIO (banks L, M and N)
+static int sunxi_uses_r_pio(void)
 {
-    if (bpi_debug>=1) printf("sunxi_writel\n");
-    uint32_t mmap_base = (uint32_t)addr & (~MAP_MASK);
-    uint32_t mmap_seek =( (uint32_t)addr - mmap_base) >> 2;
-    *(gpio_map + mmap_seek) = val;
+    int gpio;
+
+    for (gpio=0; gpio<64 && pinTobcm_BP; gpio++)
+        if (*(pinTobcm_BP + gpio) >= 0 && GPIO_BANK(*(pinTobcm_BP + gpio)) >= 11)
+            return 1;
+    return 0;
+}
+
+static void sunxi_build_pins(void)
+{
+    struct sunxi_pin *p;
+    sunxi_gpio_t *pio;
+    int gpio, pin;
+
+    for (gpio=0; gpio<64; gpio++) {
+        p = &sunxi_pins[gpio];
+        pin = pinTobcm_BP ? *(pinTobcm_BP + gpio) : -1;
+        if (pin < 0 || (pio = sunxi_bank(pin)) == NULL) {
+            p->cfg = p->dat = p->pull = &sunxi_no_reg;
+            p->bit = 0;
+            p->cfg_shift = p->pull_shift = 0;
+            continue;
+        }
+        p->cfg = &pio->CFG[0] + GPIO_CFG_INDEX(pin);
+        p->dat = &pio->DAT;
+        p->pull = &pio->PULL[0] + GPIO_PUL_INDEX(pin);
+        p->bit = 1 << GPIO_NUM(pin);
+        p->cfg_shift = GPIO_CFG_OFFSET(pin);
+        p->pull_shift = GPIO_PUL_OFFSET(pin);
+        if (bpi_debug_on(2)) printf("gpio(%d) pin(%d) bank(%d)\n", gpio, pin, GPIO_BANK(pin));
+    }
 }
 
 int sunxi_setup(void)
 {
     int mem_fd;
-    uint8_t *gpio_mem;
+    void *map;
 
     char* szDebug = getenv(ENV_DEBUG); 
     if (szDebug) {
@@ -400,162 +585,154 @@ int sunxi_setup(void)
       bpi_debug = 0;
     }
     
-    if (bpi_debug>=1) printf("sunxi_setup\n");
+    if (bpi_debug_on(1)) printf("sunxi_setup\n");
 
-    // mmap the GPIO memory registers
+    if (gpio_map)   // already mapped
+        return SETUP_OK;
+
+    // mmap the GPIO memory registers - both blocks start on a page, so the
+    // kernel can choose where they go
     if ((mem_fd = open("/dev/mem", O_RDWR|O_SYNC) ) < 0)
         return SETUP_DEVMEM_FAIL;
 
-    if ((gpio_mem = malloc(BLOCK_SIZE + (PAGE_SIZE-1))) == NULL)
-        return SETUP_MALLOC_FAIL;
-
-    if ((uint32_t)gpio_mem % PAGE_SIZE)
-        gpio_mem += PAGE_SIZE - ((uint32_t)gpio_mem % PAGE_SIZE);
-
-    gpio_map = (uint32_t *)mmap( (caddr_t)gpio_mem, BLOCK_SIZE, PROT_READ|PROT_WRITE, MAP_SHARED|MAP_FIXED, mem_fd, SUNXI_GPIO_BASE);
+    map = mmap(NULL, BLOCK_SIZE, PROT_READ|PROT_WRITE, MAP_SHARED, mem_fd, SUNXI_GPIO_BASE);
+    if (map == MAP_FAILED) {
+        close(mem_fd);
+        return SETUP_MMAP_FAIL;
+    }
+    gpio_map = map;
     pio_map = gpio_map + (SUNXI_GPIO_REG_OFFSET>>2);
-//printf("gpio_mem[%x] gpio_map[%x] pio_map[%x]\n", gpio_mem, gpio_map, pio_map);
-//R_PIO GPIO LMN
-    r_gpio_map = (uint32_t *)mmap( (caddr_t)0, BLOCK_SIZE, PROT_READ|PROT_WRITE, MAP_SHARED, mem_fd, SUNXI_R_GPIO_BASE);
-    r_pio_map = r_gpio_map + (SUNXI_R_GPIO_REG_OFFSET>>2);
-//printf("r_gpio_map[%x] r_pio_map[%x]\n", r_gpio_map, r_pio_map);
 
-    if ((uint32_t)gpio_map < 0)
+//R_PIO GPIO LMN - only needed if the header has pins in those banks
+    map = mmap(NULL, BLOCK_SIZE, PROT_READ|PROT_WRITE, MAP_SHARED, mem_fd, SUNXI_R_GPIO_BASE);
+    if (map != MAP_FAILED) {
+        r_gpio_map = map;
+        r_pio_map = r_gpio_map + (SUNXI_R_GPIO_REG_OFFSET>>2);
+    }
+    close(mem_fd);  // the mappings stay valid
+    if (r_pio_map == NULL && sunxi_uses_r_pio()) {
+        munmap((void *)gpio_map, BLOCK_SIZE);
+        gpio_map = pio_map = NULL;
         return SETUP_MMAP_FAIL;
+    }
+    if (bpi_debug_on(1)) printf("gpio_map=%p r_gpio_map=%p\n", (void *)gpio_map, (void *)r_gpio_map);
 
+    sunxi_build_pins();
     return SETUP_OK;
 }
 
+// the sunxi_* gpio calls take BCM gpio numbers (see sunxi_pins)
 void sunxi_set_pullupdn(int gpio, int pud)
 {
+    struct sunxi_pin *p = &sunxi_pins[gpio];
     uint32_t regval = 0;
-    int bank = GPIO_BANK(gpio); //gpio >> 5
-    int index = GPIO_PUL_INDEX(gpio); // (gpio & 0x1f) >> 4
-    int offset = GPIO_PUL_OFFSET(gpio); // (gpio) & 0x0F) << 1
-    if (bpi_debug>=1) printf("sunxi_set_pullupdn %d %d\n", gpio, pud);
-    if (bpi_debug>=2) printf("gpio(%d) bank(%d) index(%d) offset(%d)\n", gpio, bank, index, offset);
-
-    sunxi_gpio_t *pio = &((sunxi_gpio_reg_t *) pio_map)->gpio_bank[bank];
-/* DK, for PL and PM */
-    if(bank >= 11) {
-      bank -= 11;
-      pio = &((sunxi_gpio_reg_t *) r_pio_map)->gpio_bank[bank];
-    }
+    if (bpi_debug_on(1)) printf("sunxi_set_pullupdn %d %d\n", gpio, pud);
 
     switch(pud) {
       case PUD_DOWN:
         pud=0x2;
-        if (bpi_debug>=2) printf("pulldown\n");
+        if (bpi_debug_on(2)) printf("pulldown\n");
         break;
       case PUD_UP:
         pud=0x1;
-        if (bpi_debug>=2) printf("pullup\n");
+        if (bpi_debug_on(2)) printf("pullup\n");
         break;
       default:
-        if (bpi_debug>=2) printf("off\n");
+        if (bpi_debug_on(2)) printf("off\n");
         pud=0x0;
         break;
     }
 
-    regval = *(&pio->PULL[0] + index);
-    regval &= ~(3 << offset);
-    regval |= pud << offset;
-    *(&pio->PULL[0] + index) = regval;
-    regval = *(&pio->PULL[0] + index);
+    regval = *p->pull;
+    regval &= ~(3 << p->pull_shift);
+    regval |= pud << p->pull_shift;
+    *p->pull = regval;
 }
 
-void sunxi_setup_gpio(const int gpio, const int direction,const int pud)
+void sunxi_set_direction(const int gpio, const int direction)
 {
+    struct sunxi_pin *p = &sunxi_pins[gpio];
     uint32_t regval = 0;
-    int bank = GPIO_BANK(gpio); //gpio >> 5
-    int index = GPIO_CFG_INDEX(gpio); // (gpio & 0x1F) >> 3
-    int offset = GPIO_CFG_OFFSET(gpio); // ((gpio & 0x1F) & 0x7) << 2
-    if (bpi_debug>=1) printf("sunxi_setup_gpio %d %d %d\n", gpio, direction, pud);
-    if (bpi_debug>=2) printf("gpio(%d) bank(%d) index(%d) offset(%d)\n", gpio, bank, index, offset);
-    sunxi_gpio_t *pio = &((sunxi_gpio_reg_t *) pio_map)->gpio_bank[bank];
-/* DK, for PL and PM */
-    if(bank >= 11) {
-      bank -= 11;
-      pio = &((sunxi_gpio_reg_t *) r_pio_map)->gpio_bank[bank];
-    }
 
-    sunxi_set_pullupdn(gpio, pud);
-
-    regval = *(&pio->CFG[0] + index);
-    regval &= ~(0x7 << offset); // 0xf?
+    regval = *p->cfg;
+    regval &= ~(0x7 << p->cfg_shift); // 0xf?
     if (INPUT == direction) {
-        *(&pio->CFG[0] + index) = regval;
+        *p->cfg = regval;
     } else if (OUTPUT == direction) {
-        regval |=  (1 << offset);
-        *(&pio->CFG[0] + index) = regval;
+        regval |=  (1 << p->cfg_shift);
+        *p->cfg = regval;
     } else {
         fprintf(stderr, "gpio invalid direction");
-        if (bpi_debug>=1) printf("line:%d gpio number error\n",__LINE__);
+        if (bpi_debug_on(1)) printf("line:%d gpio number error\n",__LINE__);
     }
 }
 
+void sunxi_setup_gpio(const int gpio, const int direction,const int pud)
+{
+    if (bpi_debug_on(1)) printf("sunxi_setup_gpio %d %d %d\n", gpio, direction, pud);
+    sunxi_set_pullupdn(gpio, pud);
+    sunxi_set_direction(gpio, direction);
+}
+
 // Contribution by Eric Ptak <trouch@trouch.com>
 int sunxi_gpio_function(int gpio)
 {
+    struct sunxi_pin *p = &sunxi_pins[gpio];
     uint32_t regval = 0;
-    int bank = GPIO_BANK(gpio); //gpio >> 5
-    int index = GPIO_CFG_INDEX(gpio); // (gpio & 0x1F) >> 3
-    int offset = GPIO_CFG_OFFSET(gpio); // ((gpio & 0x1F) & 0x7) << 2
-    if (bpi_debug>=1) printf("sunxi_gpio_function\n");
-    sunxi_gpio_t *pio = &((sunxi_gpio_reg_t *) pio_map)->gpio_bank[bank];
-/* DK, for PL and PM */
-    if(bank >= 11) {
-      bank -= 11;
-      pio = &((sunxi_gpio_reg_t *) r_pio_map)->gpio_bank[bank];
-    }
+    if (bpi_debug_on(1)) printf("sunxi_gpio_function\n");
 
-    regval = *(&pio->CFG[0] + index);
-    regval >>= offset;
+    regval = *p->cfg;
+    regval >>= p->cfg_shift;
     regval &= 7;
     return regval; // 0=input, 1=output, 4=alt0
 }
 
 void sunxi_output_gpio(int gpio, int value)
 {
-    int bank = GPIO_BANK(gpio); //gpio >> 5
-    int num = GPIO_NUM(gpio); // gpio & 0x1F
-
-    if (bpi_debug>=1) printf("sunxi_output_gpio\n");
-    if (bpi_debug>=2) printf("gpio(%d) bank(%d) num(%d)\n", gpio, bank, num);
-    sunxi_gpio_t *pio = &((sunxi_gpio_reg_t *) pio_map)->gpio_bank[bank];
-/* DK, for PL and PM */
-    if(bank >= 11) {
-      bank -= 11;
-      pio = &((sunxi_gpio_reg_t *) r_pio_map)->gpio_bank[bank];
-    }
+    struct sunxi_pin *p = &sunxi_pins[gpio];
 
+    if (bpi_debug_on(1)) printf("sunxi_output_gpio %d\n", gpio);
     if (value == 0)
-        *(&pio->DAT) &= ~(1 << num);
+        *p->dat &= ~p->bit;
     else
-        *(&pio->DAT) |= (1 << num);
+        *p->dat |= p->bit;
 }
 
-int sunxi_input_gpio(int gpio)
+// bit n of set/clr is gpio n - one read-modify-write per bank
+void sunxi_output_gpio_mask(uint64_t set, uint64_t clr)
 {
-    uint32_t regval = 0;
-    int bank = GPIO_BANK(gpio); //gpio >> 5
-    int num = GPIO_NUM(gpio); // gpio & 0x1F
+    struct out_word words[64];
+    int n = 0, gpio;
 
-    if (bpi_debug>=1) printf("sunxi_input_gpio\n");
-    if (bpi_debug>=2) printf("gpio(%d) bank(%d) num(%d)\n", gpio, bank, num);
-    sunxi_gpio_t *pio = &((sunxi_gpio_reg_t *) pio_map)->gpio_bank[bank];
-/* DK, for PL and PM */
-    if(bank >= 11) {
-      bank -= 11;
-      pio = &((sunxi_gpio_reg_t *) r_pio_map)->gpio_bank[bank];
+    for (gpio=0; gpio<64; gpio++) {
+        if (!((set | clr) & (1ULL << gpio)) || sunxi_pins[gpio].dat == &sunxi_no_reg)
+            continue;
+        n = out_word_add(words, n, sunxi_pins[gpio].dat, sunxi_pins[gpio].bit, (set >> gpio) & 1);
     }
+    out_words_write(words, n);
+}
+
+// returns the levels of the gpios in mask - each DAT word is read once
+uint64_t sunxi_input_gpio_mask(uint64_t mask)
+{
+    struct in_word words[64];
+    uint64_t value = 0;
+    int n = 0, gpio;
+
+    for (gpio=0; gpio<64; gpio++)
+        if ((mask & (1ULL << gpio)) && (in_word_read(words, &n, sunxi_pins[gpio].dat) & sunxi_pins[gpio].bit))
+            value |= 1ULL << gpio;
+    return value;
+}
+
+int sunxi_input_gpio(int gpio)
+{
+    struct sunxi_pin *p = &sunxi_pins[gpio];
+    int value;
 
-    regval = *(&pio->DAT);
-    if (bpi_debug>=4) printf("dat value=%u, cfg0=%u, cfg1=%u, cfg2=%u, cfg3=%u \n", regval,*(&pio->CFG[0]),*(&pio->CFG[1]),*(&pio->CFG[2]),*(&pio->CFG[3]));
-    regval = regval >> num;
-    regval &= 1;
-    if (bpi_debug>=2) printf("value=%u\n", regval);
-    return regval;
+    value = (*p->dat & p->bit) != 0;
+    if (bpi_debug_on(2)) printf("sunxi_input_gpio %d value=%d\n", gpio, value);
+    return value;
 }
 
 int getBoardModelbyDeviceTreeModel(void)
@@ -596,7 +773,7 @@ int bpi_piGpioLayout (void)
   if (boardModel>=0) {
     gpioLayout = boardModel;
     if (gpioLayout >= BPI_MODEL_MIN) {
-      if (bpi_debug>=2) printf ("Banana Pi devicetree found layout %d\n", gpioLayout) ;
+      if (bpi_debug_on(2)) printf ("Banana Pi devicetree found layout %d\n", gpioLayout) ;
       bpi_found = 1;
       return gpioLayout;     
     }
@@ -618,7 +795,7 @@ int bpi_piGpioLayout (void)
           gpioLayout = board->model; // BPI: use model to replace gpioLayout
           //printf("BPI: name[%s] gpioLayout(%d)\n",board->name, gpioLayout);
           if(gpioLayout >= BPI_MODEL_MIN) {
-            if (bpi_debug>=2) printf ("Banana Pi '/var/lib/bananapi/board.sh' found layout %d\n", gpioLayout) ;
+            if (bpi_debug_on(2)) printf ("Banana Pi '/var/lib/bananapi/board.sh' found layout %d\n", gpioLayout) ;
             bpi_found = 1;
             break;
           }
@@ -643,18 +820,22 @@ int bpi_get_rpi_info(rpi_info *info)
   char type[64]; // please fix , return local var
 
   gpioLayout = bpi_piGpioLayout () ;
-  if (bpi_debug>=1) printf("BPI: gpioLayout(%d)\n", gpioLayout);
+  if (bpi_debug_on(1)) printf("BPI: gpioLayout(%d)\n", gpioLayout);
   if(bpi_found == 1) {
     board = &bpiboard[gpioLayout];
-    if (bpi_debug>=1) printf("BPI: name[%s] gpioLayout(%d)\n",board->name, gpioLayout);
+    if (bpi_debug_on(1)) printf("BPI: name[%s] gpioLayout(%d)\n",board->name, gpioLayout);
     sprintf(ram, "%dMB", piMemorySize[board->mem]);
     sprintf(type, "%s", piModelNames [board->model]);
      //add by jackzeng
      //jude mtk platform
     if(strcmp(board->name, "bpi-r2") == 0){
         bpi_found_mtk = 1;
-        if (bpi_debug>=1) printf("found mtk board\n");
+        if (bpi_debug_on(1)) printf("found mtk board\n");
     }
+    // A20 boards
+    if (strcmp(board->name, "bpi-m1") == 0 || strcmp(board->name, "bpi-m1p") == 0 ||
+        strcmp(board->name, "bpi-r1") == 0)
+        bpi_irq_needs_mux = 1;
     sprintf(manufacturer, "%s", piMakerNames [board->maker]);
     info->p1_revision = 3;
     info->type = type;
@@ -677,7 +858,7 @@ int bpi_get_rpi_info(rpi_info *info)
     pinToGpio_BP =  board->pinToGpio ;
     physToGpio_BP = board->physToGpio ;
     pinTobcm_BP = board->pinTobcm ;
-    if (bpi_debug>=4) printf("BPI: name[%s] model(%d)\n",board->name, board->model);
+    if (bpi_debug_on(4)) printf("BPI: name[%s] model(%d)\n",board->name, board->model);
     return 0;
   }
   return -1;
@@ -34,6 +34,36 @@ const int pin_to_gpio_rev4[41] = {-1, -1, -1, 2, -1, 3, -1, 4, 14, -1, 15, 17, 1
 int setup_error = 0;
 int module_setup = 0;
 
+int mmap_gpio_mem(void)
+{
+    int result;
+
+    if (module_setup)
+        return 0;
+
+    result = setup();
+    if (result == SETUP_DEVMEM_FAIL)
+    {
+        PyErr_SetString(PyExc_RuntimeError, "No access to /dev/mem.  Try running as root!");
+        return 1;
+    } else if (result == SETUP_MALLOC_FAIL) {
+        PyErr_NoMemory();
+        return 2;
+    } else if (result == SETUP_MMAP_FAIL) {
+        PyErr_SetString(PyExc_RuntimeError, "Mmap of GPIO registers failed");
+        return 3;
+    } else if (result == SETUP_CPUINFO_FAIL) {
+        PyErr_SetString(PyExc_RuntimeError, "Unable to open /proc/cpuinfo");
+        return 4;
+    } else if (result == SETUP_NOT_RPI_FAIL) {
+        PyErr_SetString(PyExc_RuntimeError, "Not running on a RPi!");
+        return 5;
+    } else { // result == SETUP_OK
+        module_setup = 1;
+        return 0;
+    }
+}
+
 int check_gpio_priv(void)
 {
     // check module has been imported cleanly
@@ -88,3 +118,26 @@ int get_gpio_number(int channel, unsigned int *gpio)
 
     return 0;
 }
+
+// like get_gpio_number() but None means the channel is not used (*gpio = -1)
+int get_optional_gpio_number(PyObject *channel, int *gpio)
+{
+    unsigned int g;
+
+    if (channel == Py_None) {
+        *gpio = -1;
+        return 0;
+    }
+#if PY_MAJOR_VERSION > 2
+    if (!PyLong_Check(channel)) {
+#else
+    if (!PyInt_Check(channel)) {
+#endif
+        PyErr_SetString(PyExc_ValueError, "Channel must be an integer or None");
+        return 6;
+    }
+    if (get_gpio_number((int)PyLong_AsLong(channel), &g))
+        return 7;
+    *gpio = g;
+    return 0;
+}
@@ -39,5 +39,7 @@ int gpio_direction[54];
 rpi_info rpiinfo;
 int setup_error;
 int module_setup;
+int mmap_gpio_mem(void);
 int check_gpio_priv(void);
 int get_gpio_number(int channel, unsigned int *gpio);
+int get_optional_gpio_number(PyObject *channel, int *gpio);
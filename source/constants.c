@@ -25,6 +25,7 @@ SOFTWARE.
 #include "common.h"
 #include "c_gpio.h"
 #include "event_gpio.h"
+#include "dht.h"
 
 void define_constants(PyObject *module)
 {
@@ -78,4 +79,10 @@ void define_constants(PyObject *module)
 
    both_edge = Py_BuildValue("i", BOTH_EDGE + PY_EVENT_CONST_OFFSET);
    PyModule_AddObject(module, "BOTH", both_edge);
+
+   dht11 = Py_BuildValue("i", DHT11);
+   PyModule_AddObject(module, "DHT11", dht11);
+
+   dht22 = Py_BuildValue("i", DHT22);
+   PyModule_AddObject(module, "DHT22", dht22);
 }
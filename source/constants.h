@@ -40,5 +40,7 @@ PyObject *pud_down;
 PyObject *rising_edge;
 PyObject *falling_edge;
 PyObject *both_edge;
+PyObject *dht11;
+PyObject *dht22;
 
 void define_constants(PyObject *module);
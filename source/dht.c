@@ -0,0 +1,95 @@
+/*
+Copyright (c) 2020 GC2
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+of the Software, and to permit persons to whom the Software is furnished to do
+so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <time.h>
+#include "c_gpio.h"
+#include "dht.h"
+
+#define US 1000ULL
+#define BIT_TIMEOUT (200*US)    // longest expected level is 80 us
+#define ONE_THRESHOLD (48*US)   // high for 26-28 us is a 0, 70 us is a 1
+
+// busy poll until gpio reaches level
+// returns the time the level was seen or 0 on timeout
+static unsigned long long wait_level(unsigned int gpio, int level, unsigned long long deadline)
+{
+    unsigned long long now;
+
+    do {
+        now = monotonic_ns();
+        if (!!input_gpio(gpio) == level)
+            return now;
+    } while (now < deadline);
+    return 0;
+}
+
+// return values:
+// 0 - success
+// 1 - no response or timeout
+// 2 - checksum error
+int dht_read(unsigned int gpio, int kind, float *humidity, float *temperature)
+{
+    struct timespec start_signal = {0, kind == DHT11 ? 20000000 : 1100000};
+    unsigned char data[5] = {0};
+    unsigned long long rise, fall;
+    int i, value;
+
+    // start signal - hold the line low then let the pull up release it
+    output_gpio(gpio, 0);
+    setup_gpio(gpio, INPUT, PUD_UP);
+    set_direction_gpio(gpio, OUTPUT);
+    nanosleep(&start_signal, NULL);
+    set_direction_gpio(gpio, INPUT);
+
+    // response - 80 us low, 80 us high
+    if (!wait_level(gpio, 0, monotonic_ns() + BIT_TIMEOUT) ||
+        !wait_level(gpio, 1, monotonic_ns() + BIT_TIMEOUT) ||
+        !(fall = wait_level(gpio, 0, monotonic_ns() + BIT_TIMEOUT)))
+        return 1;
+
+    // 40 bits, each 50 us low followed by the high pulse carrying the bit
+    for (i=0; i<40; i++) {
+        if (!(rise = wait_level(gpio, 1, fall + BIT_TIMEOUT)))
+            return 1;
+        if (!(fall = wait_level(gpio, 0, rise + BIT_TIMEOUT)))
+            return 1;
+        if (fall - rise > ONE_THRESHOLD)
+            data[i/8] |= 0x80 >> (i%8);
+    }
+
+    if (((data[0] + data[1] + data[2] + data[3]) & 0xff) != data[4])
+        return 2;
+
+    if (kind == DHT11) {
+        *humidity = data[0] + data[1] / 10.0f;
+        *temperature = data[2] + (data[3] & 0x7f) / 10.0f;
+        if (data[3] & 0x80)
+            *temperature = -*temperature;
+    } else {
+        *humidity = ((data[0] << 8) | data[1]) / 10.0f;
+        value = ((data[2] & 0x7f) << 8) | data[3];
+        *temperature = value / 10.0f;
+        if (data[2] & 0x80)
+            *temperature = -*temperature;
+    }
+    return 0;
+}
@@ -0,0 +1,129 @@
+/*
+Copyright (c) 2020 GC2
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+of the Software, and to permit persons to whom the Software is furnished to do
+so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <stdlib.h>
+#include "c_gpio.h"
+#include "event_gpio.h"
+#include "encoder.h"
+
+struct encoder
+{
+    unsigned int gpio_a;
+    unsigned int gpio_b;
+    int state;                      // (a << 1) | b
+    long position;
+    long long interval;             // ns between the last two steps, negative when counting down
+    unsigned long long last_step;
+};
+
+// position change indexed by (old state << 2) | new state, positive when A leads B
+static const signed char transitions[16] = {
+     0, -1,  1,  0,
+     1,  0,  0, -1,
+    -1,  0,  0,  1,
+     0,  1, -1,  0
+};
+
+// called from the event thread for every edge on A or B
+static void encoder_edge(unsigned int gpio, int level, unsigned long long timestamp, void *data)
+{
+    struct encoder *e = (struct encoder *)data;
+    int a, b, state, delta;
+    long long interval;
+
+    a = (gpio == e->gpio_a) ? level : !!input_gpio(e->gpio_a);
+    b = (gpio == e->gpio_b) ? level : !!input_gpio(e->gpio_b);
+    state = (a << 1) | b;
+    delta = transitions[(e->state << 2) | state];
+    e->state = state;
+    if (delta == 0)
+        return;   // no change, or both inputs changed and the direction is unknown
+
+    __atomic_add_fetch(&e->position, delta, __ATOMIC_SEQ_CST);
+    interval = e->last_step ? (long long)(timestamp - e->last_step) : 0;
+    __atomic_store_n(&e->interval, delta > 0 ? interval : -interval, __ATOMIC_SEQ_CST);
+    __atomic_store_n(&e->last_step, timestamp, __ATOMIC_SEQ_CST);
+}
+
+struct encoder *encoder_start(unsigned int gpio_a, unsigned int gpio_b, int *result)
+// result values:
+// 0 - Success
+// 1 - Conflicting edge detection already added
+// 2 - Other error
+{
+    struct encoder *e;
+
+    if ((e = malloc(sizeof(struct encoder))) == NULL) {
+        *result = 2;
+        return NULL;
+    }
+    e->gpio_a = gpio_a;
+    e->gpio_b = gpio_b;
+    e->state = (!!input_gpio(gpio_a) << 1) | !!input_gpio(gpio_b);
+    e->position = 0;
+    e->interval = 0;
+    e->last_step = 0;
+
+    // monitors see every transition, whatever edge add_event_detect() asked for
+    if ((*result = add_edge_monitor(gpio_a, encoder_edge, e)) != 0) {
+        free(e);
+        return NULL;
+    }
+    if ((*result = add_edge_monitor(gpio_b, encoder_edge, e)) != 0) {
+        remove_edge_monitor(gpio_a, encoder_edge, e);
+        free(e);
+        return NULL;
+    }
+    return e;
+}
+
+void encoder_stop(struct encoder *e)
+{
+    remove_edge_monitor(e->gpio_a, encoder_edge, e);
+    remove_edge_monitor(e->gpio_b, encoder_edge, e);
+    free(e);
+}
+
+long encoder_position(struct encoder *e)
+{
+    return __atomic_load_n(&e->position, __ATOMIC_SEQ_CST);
+}
+
+void encoder_set_position(struct encoder *e, long position)
+{
+    __atomic_store_n(&e->position, position, __ATOMIC_SEQ_CST);
+}
+
+// steps per second, decaying towards 0 when the encoder stops turning
+double encoder_velocity(struct encoder *e)
+{
+    long long interval = __atomic_load_n(&e->interval, __ATOMIC_SEQ_CST);
+    unsigned long long last_step = __atomic_load_n(&e->last_step, __ATOMIC_SEQ_CST);
+    unsigned long long period = interval < 0 ? -interval : interval;
+    unsigned long long since = monotonic_ns() - last_step;
+
+    if (interval == 0 || since > 1000000000ULL)
+        return 0.0;
+    if (since > period)
+        period = since;
+    return (interval < 0 ? -1E9 : 1E9) / period;
+}
@@ -29,11 +29,12 @@ SOFTWARE.
 #include <unistd.h>
 #include <string.h>
 #include <sys/time.h>
+#include <sys/timerfd.h>
+#include "c_gpio.h"
 #include "event_gpio.h"
 
 extern int bpi_found;
 extern int bpi_found_mtk;
-extern int bpi_debug;
 extern int *pinTobcm_BP;
 
 #define GPIO_ALL -666
@@ -52,11 +53,25 @@ struct callback
 };
 struct callback *callbacks = NULL;
 
+// edge monitors - C level hooks that see every edge, before bouncetime is applied
+struct monitor
+{
+    unsigned int gpio;
+    void (*func)(unsigned int gpio, int level, unsigned long long timestamp, void *data);
+    void *data;
+    struct monitor *next;
+};
+struct monitor *monitors = NULL;
+pthread_mutex_t monitor_lock = PTHREAD_MUTEX_INITIALIZER;
+
 pthread_t threads;
 int event_occurred[54] = { 0 };
 int thread_running = 0;
 int epfd_thread = -1;
 int epfd_blocking = -1;
+int debounce_timer_fd = -1;
+
+static void delete_edge_detect(unsigned int gpio);
 
 /************* /sys/class/gpio functions ************/
 #define x_write(fd, buf, len) do {                                  \
@@ -76,23 +91,23 @@ int gpio_export(unsigned int gpio)
 
     if (1==bpi_found) {
       gpio = *(pinTobcm_BP + gpio);
-      if (bpi_debug>=4) printf("translated gpio=%u\n", gpio);
+      if (bpi_debug_on(4)) printf("translated gpio=%u\n", gpio);
     }
     snprintf(filename, sizeof(filename), "/sys/class/gpio/gpio%d", gpio);
-    if (bpi_debug>=4) printf("access %s\n", filename);
+    if (bpi_debug_on(4)) printf("access %s\n", filename);
 
     /* return if gpio already exported */
     if (access(filename, F_OK) != -1) {
-      if (bpi_debug>=4) printf("access file '%s' already done\n", filename);
+      if (bpi_debug_on(4)) printf("access file '%s' already done\n", filename);
       return 0;
     }
 
     if ((fd = open("/sys/class/gpio/export", O_WRONLY)) < 0) {
-      if (bpi_debug>=1) printf("open gpio export file failed\n");
+      if (bpi_debug_on(1)) printf("open gpio export file failed\n");
       return -1;
     }
 
-    //if (bpi_debug>=4) printf("export %u\n", gpio);
+    //if (bpi_debug_on(4)) printf("export %u\n", gpio);
     len = snprintf(str_gpio, sizeof(str_gpio), "%d", gpio);
     x_write(fd, str_gpio, len);
     close(fd);
@@ -107,10 +122,10 @@ int gpio_unexport(unsigned int gpio)
 
     if (1==bpi_found) {
       gpio = *(pinTobcm_BP + gpio);
-      if (bpi_debug>=4) printf("translated gpio=%u\n", gpio);
+      if (bpi_debug_on(4)) printf("translated gpio=%u\n", gpio);
     }   
     if ((fd = open("/sys/class/gpio/unexport", O_WRONLY)) < 0) {
-        if (bpi_debug>=1) printf("open gpio unexport file failed\n");
+        if (bpi_debug_on(1)) printf("open gpio unexport file failed\n");
         return -1;
     }
     len = snprintf(str_gpio, sizeof(str_gpio), "%d", gpio);
@@ -129,7 +144,7 @@ int gpio_set_direction(unsigned int gpio, unsigned int in_flag)
 
     if (1==bpi_found) {
       gpio = *(pinTobcm_BP + gpio);
-      if (bpi_debug>=4) printf("translated gpio=%u\n", gpio);
+      if (bpi_debug_on(4)) printf("translated gpio=%u\n", gpio);
     }
     snprintf(filename, sizeof(filename), "/sys/class/gpio/gpio%d/direction", gpio);
 
@@ -142,7 +157,7 @@ int gpio_set_direction(unsigned int gpio, unsigned int in_flag)
         nanosleep(&delay, NULL);
     }
     if (retry >= 100) {
-      if (bpi_debug>=1) printf("open gpio direction file '%s' failed\n", filename);
+      if (bpi_debug_on(1)) printf("open gpio direction file '%s' failed\n", filename);
       return -1;
     }
 
@@ -159,19 +174,19 @@ int gpio_set_edge(unsigned int gpio, unsigned int edge)
 {
     int fd;
     char filename[29];
-    if (bpi_debug>=4) printf("gpio_set_edge gpio=%u, edge=%u\n",gpio, edge);
+    if (bpi_debug_on(4)) printf("gpio_set_edge gpio=%u, edge=%u\n",gpio, edge);
 
     if (1==bpi_found) {
       gpio = *(pinTobcm_BP + gpio);
-      if (bpi_debug>=4) printf("translated gpio=%u\n", gpio);
+      if (bpi_debug_on(4)) printf("translated gpio=%u\n", gpio);
     }
     snprintf(filename, sizeof(filename), "/sys/class/gpio/gpio%d/edge", gpio);
 
     if ((fd = open(filename, O_WRONLY)) < 0) {
-        if (bpi_debug>=1) printf("open gpio edge file '%s' failed\n", filename);
+        if (bpi_debug_on(1)) printf("open gpio edge file '%s' failed\n", filename);
         return -1;
     }
-    if (bpi_debug>=4) printf("edge=%s\n", stredge[edge]);
+    if (bpi_debug_on(4)) printf("edge=%s\n", stredge[edge]);
     x_write(fd, stredge[edge], strlen(stredge[edge]) + 1);
     close(fd);
     return 0;
@@ -182,15 +197,15 @@ int open_value_file(unsigned int gpio)
     int fd;
     char filename[30];
 
-    if (bpi_debug>=4) printf("open_value_file gpio=%u\n",gpio);
+    if (bpi_debug_on(4)) printf("open_value_file gpio=%u\n",gpio);
     if (1==bpi_found) {
       gpio = *(pinTobcm_BP + gpio);
-      if (bpi_debug>=4) printf("translated gpio=%u\n", gpio);
+      if (bpi_debug_on(4)) printf("translated gpio=%u\n", gpio);
     }
     // create file descriptor of value file
     snprintf(filename, sizeof(filename), "/sys/class/gpio/gpio%d/value", gpio);
     if ((fd = open(filename, O_RDONLY | O_NONBLOCK)) < 0) {
-        if (bpi_debug>=1) printf("open gpio value file '%s' failed\n", filename);
+        if (bpi_debug_on(1)) printf("open gpio value file '%s' failed\n", filename);
         return -1;
     }
     return fd;
@@ -223,17 +238,17 @@ struct gpios *new_gpio(unsigned int gpio)
 {
     struct gpios *new_gpio;
 
-    if (bpi_debug>=4) printf("new_gpio gpio=%u\n", gpio);
+    if (bpi_debug_on(4)) printf("new_gpio gpio=%u\n", gpio);
     new_gpio = malloc(sizeof(struct gpios));
     if (new_gpio == 0) {
-      if (bpi_debug>=1) printf("new_gpio memory error\n");
+      if (bpi_debug_on(1)) printf("new_gpio memory error\n");
       return NULL;  // out of memory
     }
 
     new_gpio->gpio = gpio;
     if (gpio_export(gpio) != 0) {
         free(new_gpio);
-        if (bpi_debug>=1) printf("new_gpio gpio_export failed\n");
+        if (bpi_debug_on(1)) printf("new_gpio gpio_export failed\n");
         return NULL;
     }
     new_gpio->exported = 1;
@@ -241,7 +256,7 @@ struct gpios *new_gpio(unsigned int gpio)
     if (1!=bpi_found) {
       if (gpio_set_direction(gpio,1) != 0) { // 1==input
           free(new_gpio);
-          if (bpi_debug>=1) printf("new_gpio gpio_set_direction failed\n");
+          if (bpi_debug_on(1)) printf("new_gpio gpio_set_direction failed\n");
           return NULL;
       }
     }
@@ -249,7 +264,7 @@ struct gpios *new_gpio(unsigned int gpio)
     if ((new_gpio->value_fd = open_value_file(gpio)) == -1) {
         gpio_unexport(gpio);
         free(new_gpio);
-        if (bpi_debug>=1) printf("new_gpio open_value_file failed\n");
+        if (bpi_debug_on(1)) printf("new_gpio open_value_file failed\n");
         return NULL;
     }
 
@@ -258,6 +273,10 @@ struct gpios *new_gpio(unsigned int gpio)
     new_gpio->bouncetime = NO_BOUNCETIME;
     new_gpio->lastcall = 0;
     new_gpio->thread_added = 0;
+    new_gpio->monitor_added = 0;
+    new_gpio->all_edges = 0;
+    new_gpio->debounce = 0;
+    new_gpio->settle_at = 0;
 
     if (gpio_list == NULL) {
         new_gpio->next = NULL;
@@ -265,7 +284,7 @@ struct gpios *new_gpio(unsigned int gpio)
         new_gpio->next = gpio_list;
     }
     gpio_list = new_gpio;
-    if (bpi_debug>=4) printf("new_gpio succeeded\n");
+    if (bpi_debug_on(4)) printf("new_gpio succeeded\n");
     return new_gpio;
 }
 
@@ -373,37 +392,276 @@ void remove_callbacks(unsigned int gpio)
     }
 }
 
+/******* edge monitor list functions ********/
+int add_edge_monitor(unsigned int gpio, void (*func)(unsigned int gpio, int level, unsigned long long timestamp, void *data), void *data)
+// return values:
+// 0 - Success
+// 1 - Conflicting edge detection already added
+// 2 - Other error
+{
+    struct monitor *new_m;
+    struct gpios *g;
+    int result;
+
+    g = get_gpio(gpio);
+    if (g == NULL) {
+        // nobody is watching this gpio yet, so watch both edges on behalf of the monitor
+        if ((result = add_edge_detect(gpio, BOTH_EDGE, NO_BOUNCETIME)) != 0)
+            return result;
+        g = get_gpio(gpio);
+        g->monitor_added = 1;
+        g->all_edges = 1;
+    } else if (!g->thread_added) {
+        // left over from wait_for_edge() - hand it to the event thread
+        if ((result = add_edge_detect(gpio, g->edge, NO_BOUNCETIME)) != 0)
+            return result;
+        gpio_set_edge(gpio, BOTH_EDGE);
+        g->edge = BOTH_EDGE;
+        g->monitor_added = 1;
+        g->all_edges = 1;
+    } else if (!g->all_edges) {
+        // add_event_detect() only asked for one edge, but monitors see both
+        if (gpio_set_edge(gpio, BOTH_EDGE) != 0)
+            return 2;
+        g->all_edges = 1;
+    }
+
+    new_m = malloc(sizeof(struct monitor));
+    if (new_m == 0)
+        return 2;  // out of memory
+
+    new_m->gpio = gpio;
+    new_m->func = func;
+    new_m->data = data;
+    pthread_mutex_lock(&monitor_lock);
+    new_m->next = monitors;
+    monitors = new_m;
+    pthread_mutex_unlock(&monitor_lock);
+    return 0;
+}
+
+static int remove_monitors(unsigned int gpio, void (*func)(unsigned int gpio, int level, unsigned long long timestamp, void *data), void *data)
+// removes all matching monitors (func == NULL matches any) and returns the number left for gpio
+{
+    struct monitor *m;
+    struct monitor *temp;
+    struct monitor *prev = NULL;
+    int remaining = 0;
+
+    pthread_mutex_lock(&monitor_lock);
+    m = monitors;
+    while (m != NULL)
+    {
+        if (m->gpio == gpio && (func == NULL || (m->func == func && m->data == data)))
+        {
+            if (prev == NULL)
+                monitors = m->next;
+            else
+                prev->next = m->next;
+            temp = m;
+            m = m->next;
+            free(temp);
+        } else {
+            if (m->gpio == gpio)
+                remaining++;
+            prev = m;
+            m = m->next;
+        }
+    }
+    pthread_mutex_unlock(&monitor_lock);
+    return remaining;
+}
+
+static int monitor_count(unsigned int gpio)
+{
+    struct monitor *m;
+    int count = 0;
+
+    pthread_mutex_lock(&monitor_lock);
+    for (m = monitors; m != NULL; m = m->next)
+        if (m->gpio == gpio)
+            count++;
+    pthread_mutex_unlock(&monitor_lock);
+    return count;
+}
+
+void remove_edge_monitor(unsigned int gpio, void (*func)(unsigned int gpio, int level, unsigned long long timestamp, void *data), void *data)
+{
+    struct gpios *g;
+
+    if (remove_monitors(gpio, func, data) == 0) {
+        g = get_gpio(gpio);
+        if (g == NULL)
+            return;
+        if (g->monitor_added) {
+            // edge detection was only added for the monitors
+            delete_edge_detect(gpio);
+        } else if (g->all_edges && !g->debounce) {
+            // back to just the edges add_event_detect() asked for
+            gpio_set_edge(gpio, g->edge);
+            g->all_edges = 0;
+        }
+    }
+}
+
+void run_monitors(unsigned int gpio, int level, unsigned long long timestamp)
+{
+    struct monitor *m;
+
+    pthread_mutex_lock(&monitor_lock);
+    m = monitors;
+    while (m != NULL)
+    {
+        if (m->gpio == gpio)
+            m->func(gpio, level, timestamp, m->data);
+        m = m->next;
+    }
+    pthread_mutex_unlock(&monitor_lock);
+}
+
+/******* debounce functions ********/
+void arm_debounce_timer(void)
+// (re)arm the debounce timer for the earliest pending settle time
+{
+    struct itimerspec its = {{0}};
+    unsigned long long settle_at = 0;
+    struct gpios *g = gpio_list;
+
+    while (g != NULL) {
+        if (g->settle_at && (settle_at == 0 || g->settle_at < settle_at))
+            settle_at = g->settle_at;
+        g = g->next;
+    }
+    its.it_value.tv_sec = settle_at / 1000000000ULL;
+    its.it_value.tv_nsec = settle_at % 1000000000ULL;
+    timerfd_settime(debounce_timer_fd, TFD_TIMER_ABSTIME, &its, NULL);
+}
+
+void run_debounce(unsigned long long timenow)
+// report gpios whose level has been stable for the debounce time
+{
+    struct gpios *g = gpio_list;
+    char buf;
+    int level;
+
+    while (g != NULL) {
+        if (g->settle_at && g->settle_at <= timenow) {
+            g->settle_at = 0;
+            if (pread(g->value_fd, &buf, 1, 0) == 1) {
+                level = (buf == '1');
+                if (level != g->settled_level) {
+                    g->settled_level = level;
+                    if (g->edge == BOTH_EDGE || (g->edge == RISING_EDGE && level) || (g->edge == FALLING_EDGE && !level)) {
+                        if (bpi_debug_on(4)) printf("poll_thread DEBOUNCED EVENT\n");
+                        event_occurred[g->gpio] = 1;
+                        run_callbacks(g->gpio);
+                    }
+                }
+            }
+        }
+        g = g->next;
+    }
+    arm_debounce_timer();
+}
+
+int set_edge_debounce(unsigned int gpio, int debounce)
+// debounce is the time in us the level has to be stable before an event is reported
+// return values:
+// 0 - Success
+// 2 - Other error
+{
+    struct epoll_event ev;
+    struct gpios *g = get_gpio(gpio);
+    char buf;
+
+    if (g == NULL)
+        return 2;
+
+    if (debounce_timer_fd == -1) {
+        if ((debounce_timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK)) == -1)
+            return 2;
+        ev.events = EPOLLIN;
+        ev.data.fd = debounce_timer_fd;
+        if (epoll_ctl(epfd_thread, EPOLL_CTL_ADD, debounce_timer_fd, &ev) == -1) {
+            close(debounce_timer_fd);
+            debounce_timer_fd = -1;
+            return 2;
+        }
+    }
+
+    if (pread(g->value_fd, &buf, 1, 0) != 1)
+        return 2;
+    // settled_level has to follow both edges - g->edge only filters what
+    // run_debounce() reports
+    if (gpio_set_edge(gpio, BOTH_EDGE) != 0)
+        return 2;
+    g->all_edges = 1;
+    g->settled_level = (buf == '1');
+    g->settle_at = 0;
+    g->debounce = debounce;
+    return 0;
+}
+
+int debounced_level(unsigned int gpio)
+// returns the last settled level, or -1 if debouncing is not active for gpio
+{
+    struct gpios *g = get_gpio(gpio);
+
+    if (g == NULL || !g->debounce)
+        return -1;
+    return g->settled_level;
+}
+
 void *poll_thread(void *threadarg)
 {
     struct epoll_event events;
     char buf;
     struct timeval tv_timenow;
     unsigned long long timenow;
+    unsigned long long timestamp;
+    unsigned long long expirations;
     struct gpios *g;
     int n;
-    if (bpi_debug>=4) printf("poll_thread\n");
+    if (bpi_debug_on(4)) printf("poll_thread\n");
 
     thread_running = 1;
     while (thread_running) {
-        if (bpi_debug>=4) printf("poll_thread epoll_wait\n");
+        if (bpi_debug_on(4)) printf("poll_thread epoll_wait\n");
         n = epoll_wait(epfd_thread, &events, 1, -1);
         if (n > 0) {
-            if (bpi_debug>=4) printf("poll_thread data\n");
+            timestamp = monotonic_ns();
+            if (events.data.fd == debounce_timer_fd) {
+                if (read(debounce_timer_fd, &expirations, sizeof(expirations)) == sizeof(expirations))
+                    run_debounce(timestamp);
+                continue;
+            }
+            if (bpi_debug_on(4)) printf("poll_thread data\n");
             lseek(events.data.fd, 0, SEEK_SET);
             if (read(events.data.fd, &buf, 1) != 1) {
                 thread_running = 0;
-                if (bpi_debug>=1) printf("poll_thread exit read\n");
+                if (bpi_debug_on(1)) printf("poll_thread exit read\n");
                 pthread_exit(NULL);
             }
-            if (bpi_debug>=4) printf("poll_thread get_gpio_from_value_fd\n");
+            if (bpi_debug_on(4)) printf("poll_thread get_gpio_from_value_fd\n");
             g = get_gpio_from_value_fd(events.data.fd);
             if (g->initial_thread) {     // ignore first epoll trigger
                 g->initial_thread = 0;
             } else {
+                run_monitors(g->gpio, buf == '1', timestamp);
+                if (g->debounce) {
+                    // every edge restarts the time the level has to be stable
+                    g->settle_at = timestamp + g->debounce * 1000ULL;
+                    arm_debounce_timer();
+                    continue;
+                }
+                // sysfs reports both edges for the monitors - only pass on
+                // the ones asked for
+                if (g->all_edges && g->edge != BOTH_EDGE && (buf == '1') != (g->edge == RISING_EDGE))
+                    continue;
                 gettimeofday(&tv_timenow, NULL);
                 timenow = tv_timenow.tv_sec*1E6 + tv_timenow.tv_usec;
                 if (NO_BOUNCETIME==g->bouncetime || timenow - g->lastcall > (unsigned int)g->bouncetime*1000 || g->lastcall == 0 || g->lastcall > timenow) {
-                    if (bpi_debug>=4) printf("poll_thread EVENT\n");
+                    if (bpi_debug_on(4)) printf("poll_thread EVENT\n");
                     g->lastcall = timenow;
                     event_occurred[g->gpio] = 1;
                     run_callbacks(g->gpio);
@@ -418,18 +676,68 @@ void *poll_thread(void *threadarg)
             }
             thread_running = 0;
             pthread_exit(NULL);
-            if (bpi_debug>=1) printf("poll_thread exit wait -1\n");
+            if (bpi_debug_on(1)) printf("poll_thread exit wait -1\n");
         }
     }
     thread_running = 0;
     pthread_exit(NULL);
-    if (bpi_debug>=4) printf("poll_thread exit\n");
+    if (bpi_debug_on(4)) printf("poll_thread exit\n");
 }
 
 
 void remove_edge_detect(unsigned int gpio)
+// removes the event detection and callbacks, edge monitors keep watching gpio
+{
+    struct gpios *g = get_gpio(gpio);
+
+    if (bpi_debug_on(4)) printf("remove_edge_detect gpio=%u\n",gpio);
+    if (g == NULL)
+        return;
+    if (monitor_count(gpio) == 0) {
+        delete_edge_detect(gpio);
+        return;
+    }
+
+    // hand the detection back to the monitors
+    remove_callbacks(gpio);
+    gpio_set_edge(gpio, BOTH_EDGE);
+    g->edge = BOTH_EDGE;
+    g->all_edges = 1;
+    g->monitor_added = 1;
+    g->bouncetime = NO_BOUNCETIME;
+    g->lastcall = 0;
+    g->debounce = 0;
+    g->settle_at = 0;
+    event_occurred[gpio] = 0;
+}
+
+void cancel_edge_detect(unsigned int gpio, int existed)
+// undoes a successful add_edge_detect() - existed is whether gpio_event_added()
+// was set before it
 {
-    if (bpi_debug>=4) printf("remove_edge_detect gpio=%u\n",gpio);
+    struct epoll_event ev;
+    struct gpios *g = get_gpio(gpio);
+
+    if (g == NULL)
+        return;
+    if (!existed || monitor_count(gpio)) {
+        // new, or taken over from the monitors
+        remove_edge_detect(gpio);
+        return;
+    }
+
+    // left over from wait_for_edge() - take it away from the event thread again
+    ev.events = EPOLLIN | EPOLLET | EPOLLPRI;
+    ev.data.fd = g->value_fd;
+    epoll_ctl(epfd_thread, EPOLL_CTL_DEL, g->value_fd, &ev);
+    g->thread_added = 0;
+    g->initial_thread = 1;
+}
+
+static void delete_edge_detect(unsigned int gpio)
+// removes the edge detection, callbacks and monitors of gpio
+{
+    if (bpi_debug_on(4)) printf("delete_edge_detect gpio=%u\n",gpio);
 
     struct epoll_event ev;
     struct gpios *g = get_gpio(gpio);
@@ -443,8 +751,9 @@ void remove_edge_detect(unsigned int gpio)
     ev.data.fd = g->value_fd;
     epoll_ctl(epfd_thread, EPOLL_CTL_DEL, g->value_fd, &ev);
 
-    // delete callbacks for gpio
+    // delete callbacks and monitors for gpio
     remove_callbacks(gpio);
+    remove_monitors(gpio, NULL, NULL);
 
     // btc fixme - check return result??
     gpio_set_edge(gpio, NO_EDGE);
@@ -462,7 +771,7 @@ void remove_edge_detect(unsigned int gpio)
 
 int event_detected(unsigned int gpio)
 {
-    if (bpi_debug>=4) printf("event_detected gpio=%u\n",gpio);
+    if (bpi_debug_on(4)) printf("event_detected gpio=%u\n",gpio);
     if (event_occurred[gpio]) {
         event_occurred[gpio] = 0;
         return 1;
@@ -477,7 +786,7 @@ void event_cleanup(int gpio)
     struct gpios *g = gpio_list;
     struct gpios *next_gpio = NULL;
 
-    if (bpi_debug>=4) {
+    if (bpi_debug_on(4)) {
       if (GPIO_ALL==gpio) {
         printf("event_cleanup all gpios\n");
       } else {
@@ -487,7 +796,7 @@ void event_cleanup(int gpio)
     while (g != NULL) {
         next_gpio = g->next;
         if ((GPIO_ALL == gpio) || ((int)g->gpio == gpio))
-            remove_edge_detect(g->gpio);
+            delete_edge_detect(g->gpio);
         g = next_gpio;
     }
     if (gpio_list == NULL) {
@@ -499,6 +808,10 @@ void event_cleanup(int gpio)
             close(epfd_thread);
             epfd_thread = -1;
         }
+        if (debounce_timer_fd != -1) {
+            close(debounce_timer_fd);
+            debounce_timer_fd = -1;
+        }
         thread_running = 0;
     }
 }
@@ -520,31 +833,39 @@ int add_edge_detect(unsigned int gpio, unsigned int edge, int bouncetime)
     struct gpios *g;
     int i = -1;
 
-    if (bpi_debug>=4) printf("add_edge_detect gpio=%u, edge=%u, bouncetime=%d\n",gpio, edge, bouncetime);
+    if (bpi_debug_on(4)) printf("add_edge_detect gpio=%u, edge=%u, bouncetime=%d\n",gpio, edge, bouncetime);
     i = gpio_event_added(gpio);
     if (i == 0) {    // event not already added
         if ((g = new_gpio(gpio)) == NULL) {
-            if (bpi_debug>=1) printf("error 2 (event not created)\n");
+            if (bpi_debug_on(1)) printf("error 2 (event not created)\n");
             return 2;
         }
         gpio_set_edge(gpio, edge);
         g->edge = edge;
         g->bouncetime = bouncetime;
+    } else if ((g = get_gpio(gpio))->monitor_added) {
+        // only the edge monitors are using it - take it over, sysfs keeps
+        // reporting both edges for the monitors
+        if (bpi_debug_on(4)) printf("add_edge_detect taking over from the monitors\n");
+        g->edge = edge;
+        g->bouncetime = bouncetime;
+        g->monitor_added = 0;
+        event_occurred[gpio] = 0;
+        return 0;
     } else if (i == (int)edge) {  // get existing event
-        g = get_gpio(gpio);
         if ((bouncetime != NO_BOUNCETIME && g->bouncetime != bouncetime) ||  // different event bouncetime used
             (g->thread_added))  {               // event already added
-            if (bpi_debug>=1) printf("error 1 (event already added)\n");
+            if (bpi_debug_on(1)) printf("error 1 (event already added)\n");
             return 1;
         }
     } else {
-        if (bpi_debug>=1) printf("error 1 (wrong event state)\n");
+        if (bpi_debug_on(1)) printf("error 1 (wrong event state)\n");
         return 1;
     }
 
     // create epfd_thread if not already open
     if ((epfd_thread == -1) && ((epfd_thread = epoll_create(1)) == -1)) {
-        if (bpi_debug>=1) printf("error 2 (epoll creation failed)\n");
+        if (bpi_debug_on(1)) printf("error 2 (epoll creation failed)\n");
         return 2;
     }
 
@@ -552,8 +873,8 @@ int add_edge_detect(unsigned int gpio, unsigned int edge, int bouncetime)
     ev.events = EPOLLIN | EPOLLET | EPOLLPRI;
     ev.data.fd = g->value_fd;
     if (epoll_ctl(epfd_thread, EPOLL_CTL_ADD, g->value_fd, &ev) == -1) {
-        if (bpi_debug>=1) printf("error 2 (epoll_ctl failed)\n");
-        remove_edge_detect(gpio);
+        if (bpi_debug_on(1)) printf("error 2 (epoll_ctl failed)\n");
+        delete_edge_detect(gpio);
         return 2;
     }
     g->thread_added = 1;
@@ -561,12 +882,12 @@ int add_edge_detect(unsigned int gpio, unsigned int edge, int bouncetime)
     // start poll thread if it is not already running
     if (!thread_running) {
         if (pthread_create(&threads, NULL, poll_thread, (void *)t) != 0) {
-           if (bpi_debug>=1) printf("error 2 (event thread creation failed)\n");
-           remove_edge_detect(gpio);
+           if (bpi_debug_on(1)) printf("error 2 (event thread creation failed)\n");
+           delete_edge_detect(gpio);
            return 2;
         }
     }
-    if (bpi_debug>=4) printf("add_edge_detect succeed\n");
+    if (bpi_debug_on(4)) printf("add_edge_detect succeed\n");
     return 0;
 }
 
@@ -586,7 +907,7 @@ int blocking_wait_for_edge(unsigned int gpio, unsigned int edge, int bouncetime,
     int finished = 0;
     int initial_edge = 1;
 
-    if (bpi_debug>=4) printf("blocking_wait_for_edge gpio=%u, edge=%u, bouncetime=%d, timeout=%d\n",gpio, edge, bouncetime, timeout);
+    if (bpi_debug_on(4)) printf("blocking_wait_for_edge gpio=%u, edge=%u, bouncetime=%d, timeout=%d\n",gpio, edge, bouncetime, timeout);
     if (callback_exists(gpio))
         return -1;
 
@@ -36,6 +36,11 @@ struct gpios
     int thread_added;
     int bouncetime;
     unsigned long long lastcall;
+    int monitor_added;          // detection only exists for the edge monitors
+    int all_edges;              // sysfs reports both edges, edge only filters events
+    int debounce;
+    int settled_level;
+    unsigned long long settle_at;
     struct gpios *next;
 };
 
@@ -43,7 +48,12 @@ struct gpios *get_gpio(unsigned int gpio);
 
 int add_edge_detect(unsigned int gpio, unsigned int edge, int bouncetime);
 void remove_edge_detect(unsigned int gpio);
+void cancel_edge_detect(unsigned int gpio, int existed);
 int add_edge_callback(unsigned int gpio, void (*func)(unsigned int gpio));
+int add_edge_monitor(unsigned int gpio, void (*func)(unsigned int gpio, int level, unsigned long long timestamp, void *data), void *data);
+void remove_edge_monitor(unsigned int gpio, void (*func)(unsigned int gpio, int level, unsigned long long timestamp, void *data), void *data);
+int set_edge_debounce(unsigned int gpio, int debounce);
+int debounced_level(unsigned int gpio);
 int event_detected(unsigned int gpio);
 int gpio_event_added(unsigned int gpio);
 int event_initialise(void);
@@ -0,0 +1,276 @@
+/*
+Copyright (c) 2020 GC2
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+of the Software, and to permit persons to whom the Software is furnished to do
+so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <time.h>
+#include <errno.h>
+#include "c_gpio.h"
+#include "keypad.h"
+
+#define QUEUE_SIZE 64
+#define SETTLE_NS 5000   // for the column lines to follow a row change
+
+struct keypad
+{
+    int nrows, ncols;
+    unsigned int rows[KEYPAD_MAX_LINES];
+    uint64_t col_mask[KEYPAD_MAX_LINES];
+    uint64_t all_cols;
+    unsigned long interval_ns;
+    int debounce_scans;
+    uint64_t state;                         // debounced, bit row*8+col
+    unsigned char count[KEYPAD_MAX_LINES*KEYPAD_MAX_LINES];  // scans the raw state has differed from state
+    struct keypad_event queue[QUEUE_SIZE];
+    int head, len;
+    int running;
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    struct keypad *next;
+};
+static struct keypad *keypad_list = NULL;
+static pthread_mutex_t list_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static void queue_event(struct keypad *kp, int key, int pressed, unsigned long long timestamp)
+{
+    struct keypad_event *ev;
+
+    if (kp->len == QUEUE_SIZE) {    // full - drop the oldest event
+        kp->head = (kp->head + 1) % QUEUE_SIZE;
+        kp->len--;
+    }
+    ev = &kp->queue[(kp->head + kp->len) % QUEUE_SIZE];
+    ev->row = key / KEYPAD_MAX_LINES;
+    ev->col = key % KEYPAD_MAX_LINES;
+    ev->pressed = pressed;
+    ev->timestamp = timestamp;
+    kp->len++;
+}
+
+// pull one row low at a time (keys pull the columns low against their pull
+// ups).  The rows are open drain - the latch stays low and only the selected
+// row is switched to an output, so two keys in one column never short a
+// high row to a low one
+static uint64_t scan(struct keypad *kp)
+{
+    uint64_t raw = 0;
+    uint64_t level;
+    int r, c;
+
+    for (r=0; r<kp->nrows; r++) {
+        set_direction_gpio(kp->rows[r], OUTPUT);
+        delay_ns(SETTLE_NS);
+        level = input_gpio_mask(kp->all_cols);
+        set_direction_gpio(kp->rows[r], INPUT);
+        for (c=0; c<kp->ncols; c++)
+            if (!(level & kp->col_mask[c]))
+                raw |= 1ULL << (r*KEYPAD_MAX_LINES + c);
+    }
+    return raw;
+}
+
+static void *keypad_thread(void *threadarg)
+{
+    struct keypad *kp = (struct keypad *)threadarg;
+    struct timespec next;
+    unsigned long long now;
+    uint64_t raw, changed;
+    int key, events;
+
+    clock_gettime(CLOCK_MONOTONIC, &next);
+    while (kp->running) {
+        raw = scan(kp);
+        now = monotonic_ns();
+
+        pthread_mutex_lock(&kp->lock);
+        changed = raw ^ kp->state;
+        events = 0;
+        for (key=0; key<KEYPAD_MAX_LINES*KEYPAD_MAX_LINES; key++) {
+            if (!(changed & (1ULL << key))) {
+                kp->count[key] = 0;
+            } else if (++kp->count[key] >= kp->debounce_scans) {
+                kp->count[key] = 0;
+                kp->state ^= 1ULL << key;
+                queue_event(kp, key, (raw >> key) & 1, now);
+                events = 1;
+            }
+        }
+        if (events)
+            pthread_cond_broadcast(&kp->cond);
+        pthread_mutex_unlock(&kp->lock);
+
+        next.tv_nsec += kp->interval_ns;
+        while (next.tv_nsec >= 1000000000L) {
+            next.tv_nsec -= 1000000000L;
+            next.tv_sec++;
+        }
+        while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL) == EINTR)
+            ;
+    }
+    pthread_exit(NULL);
+}
+
+// returns NULL if the thread could not be started
+struct keypad *keypad_start(const unsigned int *rows, int nrows, const unsigned int *cols, int ncols, unsigned int interval_us, int debounce_scans)
+{
+    struct keypad *kp;
+    int i;
+
+    if ((kp = calloc(1, sizeof(struct keypad))) == NULL)
+        return NULL;
+
+    kp->nrows = nrows;
+    kp->ncols = ncols;
+    for (i=0; i<nrows; i++) {
+        kp->rows[i] = rows[i];
+    }
+    for (i=0; i<ncols; i++) {
+        kp->col_mask[i] = 1ULL << cols[i];
+        kp->all_cols |= kp->col_mask[i];
+    }
+    kp->interval_ns = interval_us * 1000UL;
+    kp->debounce_scans = debounce_scans < 1 ? 1 : debounce_scans;
+    pthread_mutex_init(&kp->lock, NULL);
+    pthread_cond_init(&kp->cond, NULL);
+
+    kp->running = 1;
+    if (pthread_create(&kp->thread, NULL, keypad_thread, (void *)kp) != 0) {
+        free(kp);
+        return NULL;
+    }
+
+    pthread_mutex_lock(&list_lock);
+    kp->next = keypad_list;
+    keypad_list = kp;
+    pthread_mutex_unlock(&list_lock);
+    return kp;
+}
+
+// stop scanning - queued events can still be read
+void keypad_stop(struct keypad *kp)
+{
+    if (!kp->running)
+        return;
+    kp->running = 0;
+    pthread_join(kp->thread, NULL);
+
+    // wake anyone waiting for an event
+    pthread_mutex_lock(&kp->lock);
+    pthread_cond_broadcast(&kp->cond);
+    pthread_mutex_unlock(&kp->lock);
+}
+
+void keypad_stop_all(void)
+{
+    struct keypad *kp;
+
+    pthread_mutex_lock(&list_lock);
+    for (kp = keypad_list; kp != NULL; kp = kp->next)
+        keypad_stop(kp);
+    pthread_mutex_unlock(&list_lock);
+}
+
+// stop every keypad that scans gpio as a row or a column
+void keypad_stop_gpio(unsigned int gpio)
+{
+    struct keypad *kp;
+    int i;
+
+    pthread_mutex_lock(&list_lock);
+    for (kp = keypad_list; kp != NULL; kp = kp->next) {
+        if (kp->all_cols & (1ULL << gpio))
+            keypad_stop(kp);
+        for (i=0; i<kp->nrows; i++)
+            if (kp->rows[i] == gpio)
+                keypad_stop(kp);
+    }
+    pthread_mutex_unlock(&list_lock);
+}
+
+void keypad_free(struct keypad *kp)
+{
+    struct keypad **p;
+
+    keypad_stop(kp);
+
+    pthread_mutex_lock(&list_lock);
+    for (p = &keypad_list; *p != NULL; p = &(*p)->next)
+        if (*p == kp) {
+            *p = kp->next;
+            break;
+        }
+    pthread_mutex_unlock(&list_lock);
+
+    pthread_mutex_destroy(&kp->lock);
+    pthread_cond_destroy(&kp->cond);
+    free(kp);
+}
+
+// wait up to timeout_ms (forever if negative) for the next event
+// return values:
+// 1  - ev filled in
+// 0  - timeout
+// -1 - stopped and no events left
+int keypad_get_event(struct keypad *kp, struct keypad_event *ev, int timeout_ms)
+{
+    struct timespec deadline;
+    int result = 0;
+
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_sec += timeout_ms / 1000;
+    deadline.tv_nsec += (timeout_ms % 1000) * 1000000L;
+    if (deadline.tv_nsec >= 1000000000L) {
+        deadline.tv_nsec -= 1000000000L;
+        deadline.tv_sec++;
+    }
+
+    pthread_mutex_lock(&kp->lock);
+    while (kp->len == 0 && kp->running) {
+        if (timeout_ms < 0)
+            pthread_cond_wait(&kp->cond, &kp->lock);
+        else if (pthread_cond_timedwait(&kp->cond, &kp->lock, &deadline) == ETIMEDOUT)
+            break;
+    }
+    if (kp->len) {
+        *ev = kp->queue[kp->head];
+        kp->head = (kp->head + 1) % QUEUE_SIZE;
+        kp->len--;
+        result = 1;
+    } else if (!kp->running) {
+        result = -1;
+    }
+    pthread_mutex_unlock(&kp->lock);
+    return result;
+}
+
+// returns 1 if the key is (debounced) down
+int keypad_pressed(struct keypad *kp, int row, int col)
+{
+    int pressed;
+
+    pthread_mutex_lock(&kp->lock);
+    pressed = (kp->state >> (row*KEYPAD_MAX_LINES + col)) & 1;
+    pthread_mutex_unlock(&kp->lock);
+    return pressed;
+}
@@ -0,0 +1,43 @@
+/*
+Copyright (c) 2020 GC2
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+of the Software, and to permit persons to whom the Software is furnished to do
+so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/* Matrix keypad scanner */
+
+#define KEYPAD_MAX_LINES 8
+
+struct keypad_event
+{
+    int row;
+    int col;
+    int pressed;
+    unsigned long long timestamp;   // ns, CLOCK_MONOTONIC
+};
+
+struct keypad;
+
+struct keypad *keypad_start(const unsigned int *rows, int nrows, const unsigned int *cols, int ncols, unsigned int interval_us, int debounce_scans);
+void keypad_stop(struct keypad *kp);
+void keypad_stop_all(void);
+void keypad_stop_gpio(unsigned int gpio);
+void keypad_free(struct keypad *kp);
+int keypad_get_event(struct keypad *kp, struct keypad_event *ev, int timeout_ms);
+int keypad_pressed(struct keypad *kp, int row, int col);
@@ -0,0 +1,204 @@
+/*
+Copyright (c) 2020 GC2
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+of the Software, and to permit persons to whom the Software is furnished to do
+so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "c_gpio.h"
+#include "event_gpio.h"
+#include "measure.h"
+
+struct freq_meter
+{
+    unsigned int gpio;
+    int ref_level;                  // level after the edge that starts a period
+    int last_level;
+    unsigned long long last_ref;    // timestamp of the last period start
+    unsigned long long ref_time;    // time spent at ref_level in the current period
+    struct freq_result result;
+    pthread_mutex_t lock;
+    struct freq_meter *next;
+};
+struct freq_meter *freq_list = NULL;
+
+struct freq_meter *find_freq(unsigned int gpio)
+{
+    struct freq_meter *f = freq_list;
+
+    while (f != NULL) {
+        if (f->gpio == gpio)
+            return f;
+        f = f->next;
+    }
+    return NULL;
+}
+
+// called from the event thread for every edge
+static void freq_edge(unsigned int gpio, int level, unsigned long long timestamp, void *data)
+{
+    struct freq_meter *f = (struct freq_meter *)data;
+    struct freq_result *r = &f->result;
+    unsigned long long period;
+
+    pthread_mutex_lock(&f->lock);
+    r->edges++;
+    if (level == f->ref_level) {
+        if (f->last_ref) {
+            period = timestamp - f->last_ref;
+            if (r->periods == 0 || period < r->period_min)
+                r->period_min = period;
+            if (period > r->period_max)
+                r->period_max = period;
+            r->period_sum += period;
+            r->periods++;
+            if (f->ref_time) {   // the opposite edge was seen, so the duty cycle is known
+                r->high_sum += (f->ref_level ? f->ref_time : period - f->ref_time);
+                r->high_period_sum += period;
+            }
+        }
+        f->last_ref = timestamp;
+        f->ref_time = 0;
+    } else if (f->last_ref && f->last_level == f->ref_level) {
+        f->ref_time = timestamp - f->last_ref;
+    }
+    f->last_level = level;
+    pthread_mutex_unlock(&f->lock);
+}
+
+int freq_start(unsigned int gpio)
+// return values:
+// 0 - Success
+// 1 - Conflicting edge detection already added
+// 2 - Other error
+{
+    struct freq_meter *f;
+    int result;
+
+    if ((f = find_freq(gpio)) != NULL) {
+        // restart - the monitor may already be gone after event cleanup
+        remove_edge_monitor(gpio, freq_edge, f);
+    } else {
+        if ((f = malloc(sizeof(struct freq_meter))) == NULL)
+            return 2;
+        f->gpio = gpio;
+        pthread_mutex_init(&f->lock, NULL);
+        f->next = freq_list;
+        freq_list = f;
+    }
+    // periods start on rising edges unless only falling edges are detected
+    f->ref_level = (gpio_event_added(gpio) == FALLING_EDGE) ? 0 : 1;
+    f->last_level = -1;
+    f->last_ref = 0;
+    f->ref_time = 0;
+    memset(&f->result, 0, sizeof(struct freq_result));
+
+    if ((result = add_edge_monitor(gpio, freq_edge, f)) != 0) {
+        freq_stop(gpio);
+        return result;
+    }
+    return 0;
+}
+
+void freq_read(unsigned int gpio, struct freq_result *result, int reset)
+{
+    struct freq_meter *f;
+
+    memset(result, 0, sizeof(struct freq_result));
+    if ((f = find_freq(gpio)) == NULL)
+        return;
+
+    pthread_mutex_lock(&f->lock);
+    *result = f->result;
+    if (reset)
+        memset(&f->result, 0, sizeof(struct freq_result));
+    pthread_mutex_unlock(&f->lock);
+}
+
+void freq_stop(unsigned int gpio)
+{
+    struct freq_meter *f = freq_list;
+    struct freq_meter *prev = NULL;
+
+    while (f != NULL) {
+        if (f->gpio == gpio) {
+            if (prev == NULL)
+                freq_list = f->next;
+            else
+                prev->next = f->next;
+            remove_edge_monitor(gpio, freq_edge, f);
+            pthread_mutex_destroy(&f->lock);
+            free(f);
+            return;
+        }
+        prev = f;
+        f = f->next;
+    }
+}
+
+void freq_stop_all(void)
+{
+    while (freq_list != NULL)
+        freq_stop(freq_list->gpio);
+}
+
+// returns 1 if a frequency measurement is running for this gpio, 0 otherwise
+int freq_exists(unsigned int gpio)
+{
+    return find_freq(gpio) != NULL;
+}
+
+long long pulse_in(unsigned int gpio, int level, unsigned int timeout_us)
+// busy polls the pin level - call with the GIL released
+// returns the width of the next pulse at level in ns, or -1 on timeout
+{
+    unsigned long long deadline = monotonic_ns() + timeout_us * 1000ULL;
+    unsigned long long start;
+
+    level = !!level;
+
+    // let a pulse that is already in progress finish first
+    while (!!input_gpio(gpio) == level)
+        if (monotonic_ns() > deadline)
+            return -1;
+
+    // wait for the pulse to start
+    while (!!input_gpio(gpio) != level)
+        if (monotonic_ns() > deadline)
+            return -1;
+    start = monotonic_ns();
+
+    // wait for the pulse to end
+    while (!!input_gpio(gpio) == level)
+        if (monotonic_ns() > deadline)
+            return -1;
+    return monotonic_ns() - start;
+}
+
+long long trigger_and_measure(unsigned int out_gpio, unsigned int in_gpio, int level, unsigned int trigger_us, unsigned int timeout_us)
+// sends a trigger pulse at level on out_gpio, then measures the answering pulse on in_gpio
+{
+    level = !!level;
+    output_gpio(out_gpio, level);
+    delay_ns(trigger_us * 1000UL);
+    output_gpio(out_gpio, !level);
+    return pulse_in(in_gpio, level, timeout_us);
+}
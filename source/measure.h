@@ -0,0 +1,43 @@
+/*
+Copyright (c) 2020 GC2
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+of the Software, and to permit persons to whom the Software is furnished to do
+so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/* Frequency, period, duty cycle and pulse width measurement */
+
+struct freq_result
+{
+    unsigned long edges;
+    unsigned long periods;
+    unsigned long long period_min;      // ns
+    unsigned long long period_max;      // ns
+    unsigned long long period_sum;      // ns
+    unsigned long long high_sum;        // ns, high time of the periods in high_period_sum
+    unsigned long long high_period_sum; // ns, periods where both edges were seen
+};
+
+int freq_start(unsigned int gpio);
+void freq_read(unsigned int gpio, struct freq_result *result, int reset);
+void freq_stop(unsigned int gpio);
+void freq_stop_all(void);
+int freq_exists(unsigned int gpio);
+
+long long pulse_in(unsigned int gpio, int level, unsigned int timeout_us);
+long long trigger_and_measure(unsigned int out_gpio, unsigned int in_gpio, int level, unsigned int trigger_us, unsigned int timeout_us);
@@ -0,0 +1,266 @@
+/*
+Copyright (c) 2020 GC2
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+of the Software, and to permit persons to whom the Software is furnished to do
+so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <pthread.h>
+#include <sched.h>
+#include <string.h>
+#include "c_gpio.h"
+#include "onewire.h"
+
+#define US 1000UL
+
+#define SEARCH_ROM 0xF0
+
+struct rt_state
+{
+    int raised;
+    int policy;
+    struct sched_param param;
+};
+
+// raise this thread to SCHED_FIFO if requested and permitted
+static void rt_enter(struct onewire *ow, struct rt_state *state)
+{
+    struct sched_param param;
+
+    state->raised = 0;
+    if (!ow->realtime)
+        return;
+    if (pthread_getschedparam(pthread_self(), &state->policy, &state->param) != 0)
+        return;
+    param.sched_priority = sched_get_priority_max(SCHED_FIFO);
+    if (pthread_setschedparam(pthread_self(), SCHED_FIFO, &param) == 0)
+        state->raised = 1;
+}
+
+static void rt_exit(struct rt_state *state)
+{
+    if (state->raised)
+        pthread_setschedparam(pthread_self(), state->policy, &state->param);
+}
+
+// open drain emulation as for SoftI2C - latch at 0, switch the direction
+static void bus_low(struct onewire *ow)
+{
+    set_direction_gpio(ow->gpio, OUTPUT);
+}
+
+static void bus_release(struct onewire *ow)
+{
+    set_direction_gpio(ow->gpio, INPUT);
+}
+
+static int reset_pulse(struct onewire *ow)
+{
+    int presence;
+
+    bus_low(ow);
+    delay_ns(480*US);
+    bus_release(ow);
+    delay_ns(70*US);
+    presence = !input_gpio(ow->gpio);
+    delay_ns(410*US);
+    return presence;
+}
+
+static void write_slot(struct onewire *ow, int bit)
+{
+    bus_low(ow);
+    if (bit) {
+        delay_ns(6*US);
+        bus_release(ow);
+        delay_ns(64*US);
+    } else {
+        delay_ns(60*US);
+        bus_release(ow);
+        delay_ns(10*US);
+    }
+}
+
+static int read_slot(struct onewire *ow)
+{
+    int bit;
+
+    bus_low(ow);
+    delay_ns(6*US);
+    bus_release(ow);
+    delay_ns(9*US);
+    bit = !!input_gpio(ow->gpio);
+    delay_ns(55*US);
+    return bit;
+}
+
+static void write_byte(struct onewire *ow, unsigned char byte)
+{
+    int i;
+
+    for (i=0; i<8; i++)   // LSB first
+        write_slot(ow, (byte >> i) & 1);
+}
+
+static unsigned char read_byte(struct onewire *ow)
+{
+    unsigned char byte = 0;
+    int i;
+
+    for (i=0; i<8; i++)
+        if (read_slot(ow))
+            byte |= 1 << i;
+    return byte;
+}
+
+void onewire_setup(struct onewire *ow)
+{
+    output_gpio(ow->gpio, 0);
+    setup_gpio(ow->gpio, INPUT, PUD_UP);
+}
+
+// returns 1 if a presence pulse was seen
+int onewire_reset(struct onewire *ow)
+{
+    struct rt_state state;
+    int presence;
+
+    rt_enter(ow, &state);
+    presence = reset_pulse(ow);
+    rt_exit(&state);
+    return presence;
+}
+
+int onewire_read_bit(struct onewire *ow)
+{
+    struct rt_state state;
+    int bit;
+
+    rt_enter(ow, &state);
+    bit = read_slot(ow);
+    rt_exit(&state);
+    return bit;
+}
+
+void onewire_write_bit(struct onewire *ow, int bit)
+{
+    struct rt_state state;
+
+    rt_enter(ow, &state);
+    write_slot(ow, bit);
+    rt_exit(&state);
+}
+
+void onewire_read(struct onewire *ow, unsigned char *buf, size_t len)
+{
+    struct rt_state state;
+    size_t i;
+
+    rt_enter(ow, &state);
+    for (i=0; i<len; i++)
+        buf[i] = read_byte(ow);
+    rt_exit(&state);
+}
+
+void onewire_write(struct onewire *ow, const unsigned char *buf, size_t len)
+{
+    struct rt_state state;
+    size_t i;
+
+    rt_enter(ow, &state);
+    for (i=0; i<len; i++)
+        write_byte(ow, buf[i]);
+    rt_exit(&state);
+}
+
+// enumerate up to max device ROM codes into roms
+// return values:
+// >=0 - number of devices found
+// -1  - bus error or CRC mismatch
+int onewire_search(struct onewire *ow, unsigned char (*roms)[8], int max)
+{
+    struct rt_state state;
+    unsigned char rom[8] = {0};
+    int count = 0;
+    int last_discrepancy = 0;
+    int last_zero, n, id_bit, cmp_bit, dir;
+
+    rt_enter(ow, &state);
+    while (count < max) {
+        if (!reset_pulse(ow))
+            break;
+        write_byte(ow, SEARCH_ROM);
+        last_zero = 0;
+        for (n=1; n<=64; n++) {
+            id_bit = read_slot(ow);
+            cmp_bit = read_slot(ow);
+            if (id_bit && cmp_bit) {
+                count = -1;   // nobody answered
+                goto done;
+            }
+            if (id_bit != cmp_bit) {
+                dir = id_bit;
+            } else {
+                // discrepancy - both values present on the bus
+                if (n < last_discrepancy)
+                    dir = (rom[(n-1)/8] >> ((n-1)%8)) & 1;
+                else
+                    dir = (n == last_discrepancy);
+                if (!dir)
+                    last_zero = n;
+            }
+            if (dir)
+                rom[(n-1)/8] |= 1 << ((n-1)%8);
+            else
+                rom[(n-1)/8] &= ~(1 << ((n-1)%8));
+            write_slot(ow, dir);
+        }
+        if (onewire_crc8(rom, 8) != 0) {
+            count = -1;
+            goto done;
+        }
+        memcpy(roms[count++], rom, 8);
+        last_discrepancy = last_zero;
+        if (last_discrepancy == 0)
+            break;
+    }
+done:
+    rt_exit(&state);
+    return count;
+}
+
+// Dallas/Maxim CRC8 (polynomial x^8 + x^5 + x^4 + 1)
+unsigned char onewire_crc8(const unsigned char *buf, size_t len)
+{
+    unsigned char crc = 0;
+    unsigned char byte;
+    size_t i;
+    int bit;
+
+    for (i=0; i<len; i++) {
+        byte = buf[i];
+        for (bit=0; bit<8; bit++) {
+            if ((crc ^ byte) & 1)
+                crc = (crc >> 1) ^ 0x8C;
+            else
+                crc >>= 1;
+            byte >>= 1;
+        }
+    }
+    return crc;
+}
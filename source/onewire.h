@@ -0,0 +1,40 @@
+/*
+Copyright (c) 2020 GC2
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+of the Software, and to permit persons to whom the Software is furnished to do
+so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/* Dallas 1-Wire bus master */
+
+#include <stddef.h>
+
+struct onewire
+{
+    unsigned int gpio;
+    int realtime;       // raise to SCHED_FIFO for the duration of each operation
+};
+
+void onewire_setup(struct onewire *ow);
+int onewire_reset(struct onewire *ow);
+int onewire_read_bit(struct onewire *ow);
+void onewire_write_bit(struct onewire *ow, int bit);
+void onewire_read(struct onewire *ow, unsigned char *buf, size_t len);
+void onewire_write(struct onewire *ow, const unsigned char *buf, size_t len);
+int onewire_search(struct onewire *ow, unsigned char (*roms)[8], int max);
+unsigned char onewire_crc8(const unsigned char *buf, size_t len);
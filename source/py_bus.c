@@ -0,0 +1,282 @@
+/*
+Copyright (c) 2020 GC2
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+of the Software, and to permit persons to whom the Software is furnished to do
+so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "Python.h"
+#include "bus.h"
+#include "py_bus.h"
+#include "common.h"
+#include "c_gpio.h"
+
+// bursts at least this long are written with the GIL released
+#define BUS_RELEASE_GIL_LEN 32
+
+typedef struct
+{
+    PyObject_HEAD
+    struct bus *bus;
+    int direction;
+} BusObject;
+
+// python method Bus.__init__(self, pins, direction)
+static int Bus_init(BusObject *self, PyObject *args, PyObject *kwds)
+{
+    PyObject *pins, *seq;
+    unsigned int gpio[BUS_MAX_WIDTH];
+    uint64_t used = 0;
+    int direction, channel, width, i;
+
+    if (!PyArg_ParseTuple(args, "Oi", &pins, &direction))
+        return -1;
+
+    if ((seq = PySequence_Fast(pins, "pins must be a list/tuple of channels")) == NULL)
+        return -1;
+
+    width = PySequence_Fast_GET_SIZE(seq);
+    if (width < 1 || width > BUS_MAX_WIDTH)
+    {
+        Py_DECREF(seq);
+        PyErr_Format(PyExc_ValueError, "A bus must have between 1 and %d pins", BUS_MAX_WIDTH);
+        return -1;
+    }
+
+    for (i=0; i<width; i++)
+    {
+#if PY_MAJOR_VERSION >= 3
+        channel = (int)PyLong_AsLong(PySequence_Fast_GET_ITEM(seq, i));
+#else
+        channel = (int)PyInt_AsLong(PySequence_Fast_GET_ITEM(seq, i));
+#endif
+        if (PyErr_Occurred() || get_gpio_number(channel, &gpio[i]))
+        {
+            Py_DECREF(seq);
+            return -1;
+        }
+        if (used & (1ULL << gpio[i]))
+        {
+            Py_DECREF(seq);
+            PyErr_SetString(PyExc_ValueError, "A channel appears more than once in the bus");
+            return -1;
+        }
+        used |= 1ULL << gpio[i];
+    }
+    Py_DECREF(seq);
+
+    if (direction != INPUT && direction != OUTPUT)
+    {
+        PyErr_SetString(PyExc_ValueError, "An invalid direction was passed to Bus()");
+        return -1;
+    }
+
+    if (mmap_gpio_mem())
+        return -1;
+
+    if (self->bus != NULL)
+        bus_destroy(self->bus);
+    if ((self->bus = bus_create(gpio, width)) == NULL)
+    {
+        PyErr_NoMemory();
+        return -1;
+    }
+    self->direction = direction;
+
+    if (direction == OUTPUT)
+        bus_write(self->bus, 0);
+    for (i=0; i<width; i++)
+    {
+        setup_gpio(gpio[i], direction, PUD_OFF);
+        gpio_direction[gpio[i]] = direction;
+    }
+    return 0;
+}
+
+static int check_bus(BusObject *self, int output)
+{
+    if (self->bus == NULL)
+    {
+        PyErr_SetString(PyExc_RuntimeError, "Bus object not initialised");
+        return 1;
+    }
+
+    if (output && self->direction != OUTPUT)
+    {
+        PyErr_SetString(PyExc_RuntimeError, "The bus has not been set up as an OUTPUT");
+        return 1;
+    }
+    return check_gpio_priv();
+}
+
+// python method Bus.write(self, value)
+static PyObject *Bus_write(BusObject *self, PyObject *args)
+{
+    unsigned long value;
+
+    if (!PyArg_ParseTuple(args, "k", &value))
+        return NULL;
+
+    if (check_bus(self, 1))
+        return NULL;
+
+    bus_write(self->bus, value);
+    Py_RETURN_NONE;
+}
+
+// python method Bus.read(self)
+static PyObject *Bus_read(BusObject *self, PyObject *args)
+{
+    if (check_bus(self, 0))
+        return NULL;
+
+    return Py_BuildValue("k", (unsigned long)bus_read(self->bus));
+}
+
+// python method Bus.write_many(self, data, strobe, active=HIGH, setup_ns=0, pulse_ns=0)
+static PyObject *Bus_write_many(BusObject *self, PyObject *args, PyObject *kwds)
+{
+    Py_buffer data;
+    int channel, active = HIGH;
+    int setup_ns = 0, pulse_ns = 0;
+    unsigned int strobe;
+    size_t size, count;
+    static char *kwlist[] = {"data", "strobe", "active", "setup_ns", "pulse_ns", NULL};
+
+#if PY_MAJOR_VERSION > 2
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "y*i|iii", kwlist, &data, &channel, &active, &setup_ns, &pulse_ns))
+#else
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "s*i|iii", kwlist, &data, &channel, &active, &setup_ns, &pulse_ns))
+#endif
+        return NULL;
+
+    if (setup_ns < 0 || pulse_ns < 0)
+    {
+        PyBuffer_Release(&data);
+        PyErr_SetString(PyExc_ValueError, "setup_ns and pulse_ns must not be negative");
+        return NULL;
+    }
+
+    if (check_bus(self, 1) || get_gpio_number(channel, &strobe))
+    {
+        PyBuffer_Release(&data);
+        return NULL;
+    }
+
+    if (gpio_direction[strobe] != OUTPUT)
+    {
+        PyBuffer_Release(&data);
+        PyErr_SetString(PyExc_RuntimeError, "The strobe channel has not been set up as an OUTPUT");
+        return NULL;
+    }
+
+    if (self->bus->mask & (1ULL << strobe))
+    {
+        PyBuffer_Release(&data);
+        PyErr_SetString(PyExc_ValueError, "The strobe channel must not be one of the bus channels");
+        return NULL;
+    }
+
+    size = self->bus->width <= 8 ? 1 : self->bus->width <= 16 ? 2 : 4;
+    if (data.len % size)
+    {
+        PyBuffer_Release(&data);
+        PyErr_Format(PyExc_ValueError, "data must be a multiple of %d bytes for this bus", (int)size);
+        return NULL;
+    }
+    count = data.len / size;
+
+    if (count >= BUS_RELEASE_GIL_LEN)
+    {
+        Py_BEGIN_ALLOW_THREADS // disable GIL
+        bus_write_many(self->bus, data.buf, count, strobe, active, setup_ns, pulse_ns);
+        Py_END_ALLOW_THREADS   // enable GIL
+    } else {
+        bus_write_many(self->bus, data.buf, count, strobe, active, setup_ns, pulse_ns);
+    }
+
+    PyBuffer_Release(&data);
+    Py_RETURN_NONE;
+}
+
+// deallocation method
+static void Bus_dealloc(BusObject *self)
+{
+    if (self->bus != NULL)
+        bus_destroy(self->bus);
+    Py_TYPE(self)->tp_free((PyObject*)self);
+}
+
+static PyMethodDef
+Bus_methods[] = {
+   { "write", (PyCFunction)Bus_write, METH_VARARGS, "Output a value on the bus\nvalue - bit 0 goes to the first pin" },
+   { "read", (PyCFunction)Bus_read, METH_NOARGS, "Read the value on the bus" },
+   { "write_many", (PyCFunction)Bus_write_many, METH_VARARGS | METH_KEYWORDS, "Output a burst of values, pulsing a strobe after each one\ndata     - bytes, 1, 2 or 4 per value (little endian) depending on the bus width\nstrobe   - output channel pulsed after each value\n[active] - HIGH (default) or LOW strobe pulses\n[setup_ns] - data setup time before the strobe (default 0)\n[pulse_ns] - strobe pulse width (default 0, a single store).  HD44780 LCDs need about setup_ns=40, pulse_ns=450" },
+   { NULL }
+};
+
+PyTypeObject BusType = {
+   PyVarObject_HEAD_INIT(NULL,0)
+   "RPi.GPIO.Bus",            // tp_name
+   sizeof(BusObject),         // tp_basicsize
+   0,                         // tp_itemsize
+   (destructor)Bus_dealloc,   // tp_dealloc
+   0,                         // tp_print
+   0,                         // tp_getattr
+   0,                         // tp_setattr
+   0,                         // tp_compare
+   0,                         // tp_repr
+   0,                         // tp_as_number
+   0,                         // tp_as_sequence
+   0,                         // tp_as_mapping
+   0,                         // tp_hash
+   0,                         // tp_call
+   0,                         // tp_str
+   0,                         // tp_getattro
+   0,                         // tp_setattro
+   0,                         // tp_as_buffer
+   Py_TPFLAGS_DEFAULT | Py_TPFLAGS_BASETYPE, // tp_flag
+   "Parallel data bus class\npins      - list/tuple of channels, least significant bit first\ndirection - IN or OUT",    // tp_doc
+   0,                         // tp_traverse
+   0,                         // tp_clear
+   0,                         // tp_richcompare
+   0,                         // tp_weaklistoffset
+   0,                         // tp_iter
+   0,                         // tp_iternext
+   Bus_methods,               // tp_methods
+   0,                         // tp_members
+   0,                         // tp_getset
+   0,                         // tp_base
+   0,                         // tp_dict
+   0,                         // tp_descr_get
+   0,                         // tp_descr_set
+   0,                         // tp_dictoffset
+   (initproc)Bus_init,        // tp_init
+   0,                         // tp_alloc
+   0,                         // tp_new
+};
+
+PyTypeObject *Bus_init_BusType(void)
+{
+   // Fill in some slots in the type, and make it ready
+   BusType.tp_new = PyType_GenericNew;
+   if (PyType_Ready(&BusType) < 0)
+      return NULL;
+
+   return &BusType;
+}
@@ -0,0 +1,197 @@
+/*
+Copyright (c) 2020 GC2
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+of the Software, and to permit persons to whom the Software is furnished to do
+so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "Python.h"
+#include "encoder.h"
+#include "py_encoder.h"
+#include "common.h"
+#include "c_gpio.h"
+
+typedef struct
+{
+    PyObject_HEAD
+    struct encoder *encoder;
+} EncoderObject;
+
+// python method Encoder.__init__(self, channel_a, channel_b)
+static int Encoder_init(EncoderObject *self, PyObject *args, PyObject *kwds)
+{
+    int channel_a, channel_b;
+    unsigned int gpio_a, gpio_b;
+    int result;
+
+    if (!PyArg_ParseTuple(args, "ii", &channel_a, &channel_b))
+        return -1;
+
+    // convert channels to gpio
+    if (get_gpio_number(channel_a, &gpio_a) || get_gpio_number(channel_b, &gpio_b))
+        return -1;
+
+    if (gpio_a == gpio_b)
+    {
+        PyErr_SetString(PyExc_ValueError, "Channel A and channel B must be different");
+        return -1;
+    }
+
+    // ensure channels set as input
+    if (gpio_direction[gpio_a] != INPUT || gpio_direction[gpio_b] != INPUT)
+    {
+        PyErr_SetString(PyExc_RuntimeError, "You must setup() the GPIO channel as an input first");
+        return -1;
+    }
+
+    if (check_gpio_priv())
+        return -1;
+
+    if (self->encoder != NULL)
+        encoder_stop(self->encoder);
+
+    if ((self->encoder = encoder_start(gpio_a, gpio_b, &result)) == NULL)
+    {
+        if (result == 1)
+            PyErr_SetString(PyExc_RuntimeError, "Conflicting edge detection already enabled for this GPIO channel");
+        else
+            PyErr_SetString(PyExc_RuntimeError, "Failed to add edge detection");
+        return -1;
+    }
+    return 0;
+}
+
+static int check_running(EncoderObject *self)
+{
+    if (self->encoder == NULL)
+    {
+        PyErr_SetString(PyExc_RuntimeError, "The encoder has been stopped");
+        return 1;
+    }
+    return 0;
+}
+
+// python method Encoder.position(self)
+static PyObject *Encoder_position(EncoderObject *self, PyObject *args)
+{
+    if (check_running(self))
+        return NULL;
+    return Py_BuildValue("l", encoder_position(self->encoder));
+}
+
+// python method Encoder.velocity(self)
+static PyObject *Encoder_velocity(EncoderObject *self, PyObject *args)
+{
+    if (check_running(self))
+        return NULL;
+    return Py_BuildValue("d", encoder_velocity(self->encoder));
+}
+
+// python method Encoder.reset(self, position=0)
+static PyObject *Encoder_reset(EncoderObject *self, PyObject *args)
+{
+    long position = 0;
+
+    if (!PyArg_ParseTuple(args, "|l", &position))
+        return NULL;
+
+    if (check_running(self))
+        return NULL;
+
+    encoder_set_position(self->encoder, position);
+    Py_RETURN_NONE;
+}
+
+// python method Encoder.stop(self)
+static PyObject *Encoder_stop(EncoderObject *self, PyObject *args)
+{
+    if (self->encoder != NULL)
+    {
+        encoder_stop(self->encoder);
+        self->encoder = NULL;
+    }
+    Py_RETURN_NONE;
+}
+
+// deallocation method
+static void Encoder_dealloc(EncoderObject *self)
+{
+    if (self->encoder != NULL)
+        encoder_stop(self->encoder);
+    Py_TYPE(self)->tp_free((PyObject*)self);
+}
+
+static PyMethodDef
+Encoder_methods[] = {
+   { "position", (PyCFunction)Encoder_position, METH_NOARGS, "Return the position in steps (positive when A leads B)" },
+   { "velocity", (PyCFunction)Encoder_velocity, METH_NOARGS, "Return the velocity in steps per second" },
+   { "reset", (PyCFunction)Encoder_reset, METH_VARARGS, "Set the position\n[position] - new position (default 0)" },
+   { "stop", (PyCFunction)Encoder_stop, METH_NOARGS, "Stop decoding" },
+   { NULL }
+};
+
+PyTypeObject EncoderType = {
+   PyVarObject_HEAD_INIT(NULL,0)
+   "RPi.GPIO.Encoder",        // tp_name
+   sizeof(EncoderObject),     // tp_basicsize
+   0,                         // tp_itemsize
+   (destructor)Encoder_dealloc, // tp_dealloc
+   0,                         // tp_print
+   0,                         // tp_getattr
+   0,                         // tp_setattr
+   0,                         // tp_compare
+   0,                         // tp_repr
+   0,                         // tp_as_number
+   0,                         // tp_as_sequence
+   0,                         // tp_as_mapping
+   0,                         // tp_hash
+   0,                         // tp_call
+   0,                         // tp_str
+   0,                         // tp_getattro
+   0,                         // tp_setattro
+   0,                         // tp_as_buffer
+   Py_TPFLAGS_DEFAULT | Py_TPFLAGS_BASETYPE, // tp_flag
+   "Quadrature encoder class",    // tp_doc
+   0,                         // tp_traverse
+   0,                         // tp_clear
+   0,                         // tp_richcompare
+   0,                         // tp_weaklistoffset
+   0,                         // tp_iter
+   0,                         // tp_iternext
+   Encoder_methods,           // tp_methods
+   0,                         // tp_members
+   0,                         // tp_getset
+   0,                         // tp_base
+   0,                         // tp_dict
+   0,                         // tp_descr_get
+   0,                         // tp_descr_set
+   0,                         // tp_dictoffset
+   (initproc)Encoder_init,    // tp_init
+   0,                         // tp_alloc
+   0,                         // tp_new
+};
+
+PyTypeObject *Encoder_init_EncoderType(void)
+{
+   // Fill in some slots in the type, and make it ready
+   EncoderType.tp_new = PyType_GenericNew;
+   if (PyType_Ready(&EncoderType) < 0)
+      return NULL;
+
+   return &EncoderType;
+}
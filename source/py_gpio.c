@@ -24,9 +24,24 @@ SOFTWARE.
 #include "c_gpio.h"
 #include "event_gpio.h"
 #include "py_pwm.h"
+#include "py_encoder.h"
+#include "py_soft_spi.h"
+#include "py_soft_i2c.h"
+#include "py_onewire.h"
+#include "py_bus.h"
+#include "py_keypad.h"
+#include "py_stepper.h"
+#include "py_servo.h"
 #include "cpuinfo.h"
 #include "constants.h"
 #include "common.h"
+#include "measure.h"
+#include "ws2812.h"
+#include "dht.h"
+#include "keypad.h"
+#include "stepper.h"
+#include "servo.h"
+#include "recorder.h"
 
 #ifndef BPI
 #define BPI
@@ -48,36 +63,6 @@ struct py_callback
 };
 static struct py_callback *py_callbacks = NULL;
 
-static int mmap_gpio_mem(void)
-{
-   int result;
-
-   if (module_setup)
-      return 0;
-
-   result = setup();
-   if (result == SETUP_DEVMEM_FAIL)
-   {
-      PyErr_SetString(PyExc_RuntimeError, "No access to /dev/mem.  Try running as root!");
-      return 1;
-   } else if (result == SETUP_MALLOC_FAIL) {
-      PyErr_NoMemory();
-      return 2;
-   } else if (result == SETUP_MMAP_FAIL) {
-      PyErr_SetString(PyExc_RuntimeError, "Mmap of GPIO registers failed");
-      return 3;
-   } else if (result == SETUP_CPUINFO_FAIL) {
-      PyErr_SetString(PyExc_RuntimeError, "Unable to open /proc/cpuinfo");
-      return 4;
-   } else if (result == SETUP_NOT_RPI_FAIL) {
-      PyErr_SetString(PyExc_RuntimeError, "Not running on a RPi!");
-      return 5;
-   } else { // result == SETUP_OK
-      module_setup = 1;
-      return 0;
-   }
-}
-
 // python function cleanup(channel=None)
 static PyObject *py_cleanup(PyObject *self, PyObject *args, PyObject *kwargs)
 {
@@ -93,7 +78,12 @@ static PyObject *py_cleanup(PyObject *self, PyObject *args, PyObject *kwargs)
 
    void cleanup_one(void)
    {
+      // stop measurements, keypad scans, stepper moves and servo pulses and
       // clean up any /sys/class exports
+      freq_stop(gpio);
+      keypad_stop_gpio(gpio);
+      stepper_stop_gpio(gpio);
+      servo_stop(gpio);
       event_cleanup(gpio);
 
       // set everything back to input
@@ -133,7 +123,12 @@ static PyObject *py_cleanup(PyObject *self, PyObject *args, PyObject *kwargs)
 
    if (module_setup && !setup_error) {
       if (channel == -666 && chancount == -666) {   // channel not set - cleanup everything
-         // clean up any /sys/class exports
+         // stop measurements and scanners and clean up any /sys/class exports
+         freq_stop_all();
+         keypad_stop_all();
+         stepper_stop_all();
+         servo_stop_all();
+         recorder_stop();
          event_cleanup_all();
 
          // set everything back to input
@@ -196,7 +191,7 @@ static PyObject *py_setup_channel(PyObject *self, PyObject *args, PyObject *kwar
    unsigned int gpio;
    int channel = -1;
    int direction;
-   int i, chancount;
+   int i, pass, chancount;
    PyObject *chanlist = NULL;
    PyObject *chantuple = NULL;
    PyObject *tempobj;
@@ -204,6 +199,9 @@ static PyObject *py_setup_channel(PyObject *self, PyObject *args, PyObject *kwar
    int initial = -1;
    static char *kwlist[] = {"channel", "direction", "pull_up_down", "initial", NULL};
    int func;
+   int pull_done = 0;
+   uint64_t mask = 0;
+   uint64_t fsel_mask = 0;
 
    int setup_one(void) {
       if (get_gpio_number(channel, &gpio))
@@ -230,7 +228,10 @@ static PyObject *py_setup_channel(PyObject *self, PyObject *args, PyObject *kwar
       if (direction == OUTPUT && (initial == LOW || initial == HIGH)) {
          output_gpio(gpio, initial);
       }
-      setup_gpio(gpio, direction, pud);
+      if (pull_done)
+         fsel_mask |= 1ULL << gpio;
+      else
+         setup_gpio(gpio, direction, pud);
       gpio_direction[gpio] = direction;
       return 1;
    }
@@ -303,35 +304,61 @@ static PyObject *py_setup_channel(PyObject *self, PyObject *args, PyObject *kwar
        Py_RETURN_NONE;
    }
 
-   for (i=0; i<chancount; i++) {
-      if (chanlist) {
-         if ((tempobj = PyList_GetItem(chanlist, i)) == NULL) {
-            return NULL;
-         }
-      } else { // assume chantuple
-         if ((tempobj = PyTuple_GetItem(chantuple, i)) == NULL) {
-            return NULL;
+   // two passes - set the pulls of all the channels at once, then set up
+   // each channel without repeating the pull sequence.  The first pass stops
+   // quietly at a bad channel so that the second one reports it in order.
+   // When the pulls were set in one go the second pass only collects the
+   // channels, and the function selects are written once at the end - also
+   // for the channels before a bad one
+   for (pass=0; pass<2; pass++) {
+      for (i=0; i<chancount; i++) {
+         if (chanlist) {
+            if ((tempobj = PyList_GetItem(chanlist, i)) == NULL) {
+               break;
+            }
+         } else { // assume chantuple
+            if ((tempobj = PyTuple_GetItem(chantuple, i)) == NULL) {
+               break;
+            }
          }
-      }
 
 #if PY_MAJOR_VERSION > 2
-      if (PyLong_Check(tempobj)) {
-         channel = (int)PyLong_AsLong(tempobj);
+         if (PyLong_Check(tempobj)) {
+            channel = (int)PyLong_AsLong(tempobj);
 #else
-      if (PyInt_Check(tempobj)) {
-         channel = (int)PyInt_AsLong(tempobj);
+         if (PyInt_Check(tempobj)) {
+            channel = (int)PyInt_AsLong(tempobj);
 #endif
-         if (PyErr_Occurred())
-             return NULL;
-      } else {
-          PyErr_SetString(PyExc_ValueError, "Channel must be an integer");
-          return NULL;
-      }
+            if (PyErr_Occurred())
+                break;
+         } else if (pass == 0) {
+            break;
+         } else {
+             PyErr_SetString(PyExc_ValueError, "Channel must be an integer");
+             break;
+         }
 
-      if (!setup_one())
-         return NULL;
+         if (pass == 0) {
+            if (get_gpio_number(channel, &gpio)) {
+               PyErr_Clear();
+               break;
+            }
+            mask |= 1ULL << gpio;
+         } else if (!setup_one()) {
+            break;
+         }
+      }
+      if (PyErr_Occurred())
+         break;
+      if (pass == 0 && mask)
+         pull_done = (set_pullupdn_mask(mask, pud) == 0);
    }
 
+   if (fsel_mask)
+      set_direction_gpio_mask(fsel_mask, direction);
+   if (PyErr_Occurred())
+      return NULL;
+
    Py_RETURN_NONE;
 }
 
@@ -681,16 +708,17 @@ static PyObject *py_add_event_callback(PyObject *self, PyObject *args, PyObject
    Py_RETURN_NONE;
 }
 
-// python function add_event_detect(gpio, edge, callback=None, bouncetime=None)
+// python function add_event_detect(gpio, edge, callback=None, bouncetime=None, debounce=None)
 static PyObject *py_add_event_detect(PyObject *self, PyObject *args, PyObject *kwargs)
 {
    unsigned int gpio;
-   int channel, edge, result;
+   int channel, edge, result, existed;
    int bouncetime = -666;
+   int debounce = -666;
    PyObject *cb_func = NULL;
-   char *kwlist[] = {"gpio", "edge", "callback", "bouncetime", NULL};
+   char *kwlist[] = {"gpio", "edge", "callback", "bouncetime", "debounce", NULL};
 
-   if (!PyArg_ParseTupleAndKeywords(args, kwargs, "ii|Oi", kwlist, &channel, &edge, &cb_func, &bouncetime))
+   if (!PyArg_ParseTupleAndKeywords(args, kwargs, "ii|Oii", kwlist, &channel, &edge, &cb_func, &bouncetime, &debounce))
       return NULL;
 
    if (cb_func != NULL && !PyCallable_Check(cb_func))
@@ -723,9 +751,22 @@ static PyObject *py_add_event_detect(PyObject *self, PyObject *args, PyObject *k
       return NULL;
    }
 
+   if (debounce <= 0 && debounce != -666)
+   {
+      PyErr_SetString(PyExc_ValueError, "Debounce must be greater than 0");
+      return NULL;
+   }
+
+   if (debounce != -666 && bouncetime != -666)
+   {
+      PyErr_SetString(PyExc_ValueError, "Use either bouncetime or debounce, not both");
+      return NULL;
+   }
+
    if (check_gpio_priv())
       return NULL;
 
+   existed = gpio_event_added(gpio);
    if ((result = add_edge_detect(gpio, edge, bouncetime)) != 0)   // starts a thread
    {
       if (result == 1)
@@ -738,6 +779,13 @@ static PyObject *py_add_event_detect(PyObject *self, PyObject *args, PyObject *k
       }
    }
 
+   if (debounce != -666 && set_edge_debounce(gpio, debounce) != 0)
+   {
+      cancel_edge_detect(gpio, existed);
+      PyErr_SetString(PyExc_RuntimeError, "Failed to add debounce");
+      return NULL;
+   }
+
    if (cb_func != NULL)
       if (add_py_callback(gpio, cb_func) != 0)
          return NULL;
@@ -805,6 +853,28 @@ static PyObject *py_event_detected(PyObject *self, PyObject *args)
       Py_RETURN_FALSE;
 }
 
+// python function value = debounced_input(channel)
+static PyObject *py_debounced_input(PyObject *self, PyObject *args)
+{
+   unsigned int gpio;
+   int channel;
+   int level;
+
+   if (!PyArg_ParseTuple(args, "i", &channel))
+      return NULL;
+
+   if (get_gpio_number(channel, &gpio))
+       return NULL;
+
+   if ((level = debounced_level(gpio)) == -1)
+   {
+      PyErr_SetString(PyExc_RuntimeError, "Add event detection with debounce using add_event_detect first");
+      return NULL;
+   }
+
+   return Py_BuildValue("i", level ? HIGH : LOW);
+}
+
 // python function channel = wait_for_edge(channel, edge, bouncetime=None, timeout=None)
 static PyObject *py_wait_for_edge(PyObject *self, PyObject *args, PyObject *kwargs)
 {
@@ -869,6 +939,603 @@ static PyObject *py_wait_for_edge(PyObject *self, PyObject *args, PyObject *kwar
 
 }
 
+static int get_freq_gpio(int channel, unsigned int *gpio)
+{
+   if (get_gpio_number(channel, gpio))
+      return 1;
+
+   // check channel is setup as an input
+   if (gpio_direction[*gpio] != INPUT)
+   {
+      PyErr_SetString(PyExc_RuntimeError, "You must setup() the GPIO channel as an input first");
+      return 1;
+   }
+
+   if (check_gpio_priv())
+      return 1;
+   return 0;
+}
+
+static int start_freq(unsigned int gpio)
+{
+   int result;
+
+   if ((result = freq_start(gpio)) != 0)
+   {
+      if (result == 1)
+         PyErr_SetString(PyExc_RuntimeError, "Conflicting edge detection already enabled for this GPIO channel");
+      else
+         PyErr_SetString(PyExc_RuntimeError, "Failed to add edge detection");
+      return 1;
+   }
+   return 0;
+}
+
+static PyObject *build_freq_result(struct freq_result *r)
+{
+   double frequency = 0.0;
+   double period_avg = 0.0;
+   double duty_cycle = 0.0;
+
+   if (r->periods) {
+      period_avg = (double)r->period_sum / r->periods;
+      frequency = 1E9 / period_avg;
+   }
+   if (r->high_period_sum)
+      duty_cycle = 100.0 * r->high_sum / r->high_period_sum;
+
+   // periods are returned in microseconds, the duty cycle in percent like PWM
+   return Py_BuildValue("{sdsdsdsdsdsk}",
+                        "frequency", frequency,
+                        "period_min", r->period_min / 1000.0,
+                        "period_max", r->period_max / 1000.0,
+                        "period_avg", period_avg / 1000.0,
+                        "duty_cycle", duty_cycle,
+                        "edges", r->edges);
+}
+
+// python function result = measure_frequency(channel, window_ms)
+static PyObject *py_measure_frequency(PyObject *self, PyObject *args, PyObject *kwargs)
+{
+   unsigned int gpio;
+   int channel;
+   int window;
+   struct timespec req, rem;
+   struct freq_result r;
+   static char *kwlist[] = {"channel", "window_ms", NULL};
+
+   if (!PyArg_ParseTupleAndKeywords(args, kwargs, "ii", kwlist, &channel, &window))
+      return NULL;
+
+   if (get_freq_gpio(channel, &gpio))
+      return NULL;
+
+   if (window <= 0)
+   {
+      PyErr_SetString(PyExc_ValueError, "window_ms must be greater than 0");
+      return NULL;
+   }
+
+   if (freq_exists(gpio))
+   {
+      PyErr_SetString(PyExc_RuntimeError, "Frequency measurement already running for this GPIO channel - use read_frequency() instead");
+      return NULL;
+   }
+
+   if (start_freq(gpio))
+      return NULL;
+
+   req.tv_sec = window / 1000;
+   req.tv_nsec = (window % 1000) * 1000000L;
+   Py_BEGIN_ALLOW_THREADS // disable GIL
+   while (nanosleep(&req, &rem) == -1)
+      req = rem;
+   Py_END_ALLOW_THREADS   // enable GIL
+
+   freq_read(gpio, &r, 0);
+   freq_stop(gpio);
+   return build_freq_result(&r);
+}
+
+// python function start_frequency(channel)
+static PyObject *py_start_frequency(PyObject *self, PyObject *args)
+{
+   unsigned int gpio;
+   int channel;
+
+   if (!PyArg_ParseTuple(args, "i", &channel))
+      return NULL;
+
+   if (get_freq_gpio(channel, &gpio))
+      return NULL;
+
+   if (start_freq(gpio))
+      return NULL;
+
+   Py_RETURN_NONE;
+}
+
+// python function result = read_frequency(channel, reset=False)
+static PyObject *py_read_frequency(PyObject *self, PyObject *args, PyObject *kwargs)
+{
+   unsigned int gpio;
+   int channel;
+   int reset = 0;
+   struct freq_result r;
+   static char *kwlist[] = {"channel", "reset", NULL};
+
+   if (!PyArg_ParseTupleAndKeywords(args, kwargs, "i|i", kwlist, &channel, &reset))
+      return NULL;
+
+   if (get_gpio_number(channel, &gpio))
+      return NULL;
+
+   if (!freq_exists(gpio))
+   {
+      PyErr_SetString(PyExc_RuntimeError, "Start frequency measurement using start_frequency() first");
+      return NULL;
+   }
+
+   freq_read(gpio, &r, reset);
+   return build_freq_result(&r);
+}
+
+// python function stop_frequency(channel)
+static PyObject *py_stop_frequency(PyObject *self, PyObject *args)
+{
+   unsigned int gpio;
+   int channel;
+
+   if (!PyArg_ParseTuple(args, "i", &channel))
+      return NULL;
+
+   if (get_gpio_number(channel, &gpio))
+      return NULL;
+
+   freq_stop(gpio);
+   Py_RETURN_NONE;
+}
+
+// python function start_recording(path, channel, capacity=65536)
+static PyObject *py_start_recording(PyObject *self, PyObject *args, PyObject *kwargs)
+{
+   char *path;
+   PyObject *chanobj, *seq = NULL;
+   unsigned int gpio;
+   Py_ssize_t capacity = 65536;
+   int channel, count, i, result;
+   static char *kwlist[] = {"path", "channel", "capacity", NULL};
+
+   if (!PyArg_ParseTupleAndKeywords(args, kwargs, "sO|n", kwlist, &path, &chanobj, &capacity))
+      return NULL;
+
+   if (capacity <= 0)
+   {
+      PyErr_SetString(PyExc_ValueError, "capacity must be greater than 0");
+      return NULL;
+   }
+
+   if (PyList_Check(chanobj) || PyTuple_Check(chanobj))
+   {
+      seq = PySequence_Fast(chanobj, "");
+      count = PySequence_Fast_GET_SIZE(seq);
+   } else {
+      count = 1;
+   }
+
+   // check every channel before creating the file
+   for (i=0; i<count; i++)
+   {
+#if PY_MAJOR_VERSION >= 3
+      channel = (int)PyLong_AsLong(seq ? PySequence_Fast_GET_ITEM(seq, i) : chanobj);
+#else
+      channel = (int)PyInt_AsLong(seq ? PySequence_Fast_GET_ITEM(seq, i) : chanobj);
+#endif
+      if (PyErr_Occurred() || get_freq_gpio(channel, &gpio))
+      {
+         Py_XDECREF(seq);
+         return NULL;
+      }
+   }
+
+   if ((result = recorder_start(path, (unsigned long)capacity)) != 0)
+   {
+      Py_XDECREF(seq);
+      if (result == 1)
+         PyErr_SetString(PyExc_RuntimeError, "Edge recording is already running");
+      else if (result == 3)
+         PyErr_SetString(PyExc_ValueError, "capacity is too large");
+      else
+         PyErr_SetFromErrnoWithFilename(PyExc_IOError, path);
+      return NULL;
+   }
+
+   for (i=0; i<count; i++)
+   {
+#if PY_MAJOR_VERSION >= 3
+      channel = (int)PyLong_AsLong(seq ? PySequence_Fast_GET_ITEM(seq, i) : chanobj);
+#else
+      channel = (int)PyInt_AsLong(seq ? PySequence_Fast_GET_ITEM(seq, i) : chanobj);
+#endif
+      get_gpio_number(channel, &gpio);
+      if ((result = recorder_add(gpio)) != 0)
+      {
+         recorder_stop();
+         Py_XDECREF(seq);
+         if (result == 1)
+            PyErr_SetString(PyExc_RuntimeError, "Conflicting edge detection already enabled for this GPIO channel");
+         else
+            PyErr_SetString(PyExc_RuntimeError, "Failed to add edge detection");
+         return NULL;
+      }
+   }
+
+   Py_XDECREF(seq);
+   Py_RETURN_NONE;
+}
+
+// python function stop_recording()
+static PyObject *py_stop_recording(PyObject *self, PyObject *args)
+{
+   recorder_stop();
+   Py_RETURN_NONE;
+}
+
+// python function width = pulse_in(channel, level, timeout_us=1000000)
+static PyObject *py_pulse_in(PyObject *self, PyObject *args, PyObject *kwargs)
+{
+   unsigned int gpio;
+   int channel, level;
+   int timeout = 1000000;
+   long long width;
+   static char *kwlist[] = {"channel", "level", "timeout_us", NULL};
+
+   if (!PyArg_ParseTupleAndKeywords(args, kwargs, "ii|i", kwlist, &channel, &level, &timeout))
+      return NULL;
+
+   if (get_gpio_number(channel, &gpio))
+      return NULL;
+
+   // check channel is set up as an input or output
+   if (gpio_direction[gpio] != INPUT && gpio_direction[gpio] != OUTPUT)
+   {
+      PyErr_SetString(PyExc_RuntimeError, "You must setup() the GPIO channel first");
+      return NULL;
+   }
+
+   if (timeout <= 0)
+   {
+      PyErr_SetString(PyExc_ValueError, "Timeout must be greater than 0");
+      return NULL;
+   }
+
+   if (check_gpio_priv())
+      return NULL;
+
+   Py_BEGIN_ALLOW_THREADS // disable GIL
+   width = pulse_in(gpio, level, timeout);
+   Py_END_ALLOW_THREADS   // enable GIL
+
+   if (width < 0)
+      Py_RETURN_NONE;
+   return Py_BuildValue("L", width);
+}
+
+// python function width = trigger_and_measure(out_channel, in_channel, level=HIGH, trigger_us=10, timeout_us=1000000)
+static PyObject *py_trigger_and_measure(PyObject *self, PyObject *args, PyObject *kwargs)
+{
+   unsigned int out_gpio, in_gpio;
+   int out_channel, in_channel;
+   int level = HIGH;
+   int trigger = 10;
+   int timeout = 1000000;
+   long long width;
+   static char *kwlist[] = {"out_channel", "in_channel", "level", "trigger_us", "timeout_us", NULL};
+
+   if (!PyArg_ParseTupleAndKeywords(args, kwargs, "ii|iii", kwlist, &out_channel, &in_channel, &level, &trigger, &timeout))
+      return NULL;
+
+   if (get_gpio_number(out_channel, &out_gpio) || get_gpio_number(in_channel, &in_gpio))
+      return NULL;
+
+   if (gpio_direction[out_gpio] != OUTPUT)
+   {
+      PyErr_SetString(PyExc_RuntimeError, "The GPIO channel has not been set up as an OUTPUT");
+      return NULL;
+   }
+
+   if (gpio_direction[in_gpio] != INPUT)
+   {
+      PyErr_SetString(PyExc_RuntimeError, "You must setup() the GPIO channel as an input first");
+      return NULL;
+   }
+
+   if (trigger <= 0 || timeout <= 0)
+   {
+      PyErr_SetString(PyExc_ValueError, "trigger_us and timeout_us must be greater than 0");
+      return NULL;
+   }
+
+   if (check_gpio_priv())
+      return NULL;
+
+   Py_BEGIN_ALLOW_THREADS // disable GIL
+   width = trigger_and_measure(out_gpio, in_gpio, level, trigger, timeout);
+   Py_END_ALLOW_THREADS   // enable GIL
+
+   if (width < 0)
+      Py_RETURN_NONE;
+   return Py_BuildValue("L", width);
+}
+
+// python function ws2812_write(channel, data, order='GRB')
+static PyObject *py_ws2812_write(PyObject *self, PyObject *args, PyObject *kwargs)
+{
+   PyObject *chanobj, *dataobj;
+   PyObject *chanseq = NULL, *dataseq = NULL;
+   PyObject *result = NULL;
+   char *order_str = "GRB";
+   static char *kwlist[] = {"channel", "data", "order", NULL};
+   struct ws2812_strip strips[64];
+   Py_buffer views[64];
+   struct ws2812_bit *stream;
+   size_t nbits;
+   static const char colours[] = "RGB";
+   const char *colour;
+   int order[3];
+   int count, held = 0;
+   int channel, i;
+   unsigned int gpio;
+
+   if (!PyArg_ParseTupleAndKeywords(args, kwargs, "OO|s", kwlist, &chanobj, &dataobj, &order_str))
+      return NULL;
+
+   order[0] = order[1] = order[2] = -1;
+   if (strlen(order_str) == 3)
+      for (i=0; i<3; i++)
+         if ((colour = strchr(colours, order_str[i])) != NULL)
+            order[i] = colour - colours;
+   if (order[0] < 0 || order[1] < 0 || order[2] < 0 ||
+       order[0] == order[1] || order[0] == order[2] || order[1] == order[2])
+   {
+      PyErr_SetString(PyExc_ValueError, "order must be a permutation of 'RGB'");
+      return NULL;
+   }
+
+   // a single channel with a single buffer, or matching sequences of both
+   if (PyList_Check(chanobj) || PyTuple_Check(chanobj))
+   {
+      chanseq = PySequence_Fast(chanobj, "");
+      dataseq = PySequence_Fast(dataobj, "data must be a list/tuple of buffers when channel is a list/tuple");
+      if (chanseq == NULL || dataseq == NULL)
+         goto done;
+      count = PySequence_Fast_GET_SIZE(chanseq);
+      if (count != PySequence_Fast_GET_SIZE(dataseq))
+      {
+         PyErr_SetString(PyExc_RuntimeError, "Number of channels != number of buffers");
+         goto done;
+      }
+   } else {
+      count = 1;
+   }
+
+   if (count > 64)
+   {
+      PyErr_SetString(PyExc_ValueError, "Too many channels");
+      goto done;
+   }
+
+   for (i=0; i<count; i++)
+   {
+#if PY_MAJOR_VERSION >= 3
+      channel = (int)PyLong_AsLong(chanseq ? PySequence_Fast_GET_ITEM(chanseq, i) : chanobj);
+#else
+      channel = (int)PyInt_AsLong(chanseq ? PySequence_Fast_GET_ITEM(chanseq, i) : chanobj);
+#endif
+      if (PyErr_Occurred())
+         goto done;
+
+      if (get_gpio_number(channel, &gpio))
+         goto done;
+
+      if (gpio_direction[gpio] != OUTPUT)
+      {
+         PyErr_SetString(PyExc_RuntimeError, "The GPIO channel has not been set up as an OUTPUT");
+         goto done;
+      }
+
+      if (PyObject_GetBuffer(dataseq ? PySequence_Fast_GET_ITEM(dataseq, i) : dataobj, &views[i], PyBUF_SIMPLE))
+         goto done;
+      held++;
+
+      if (views[i].len % 3)
+      {
+         PyErr_SetString(PyExc_ValueError, "data must contain 3 bytes (R, G, B) per LED");
+         goto done;
+      }
+
+      strips[i].gpio = gpio;
+      strips[i].rgb = (const unsigned char *)views[i].buf;
+      strips[i].len = views[i].len;
+   }
+
+   if (check_gpio_priv())
+      goto done;
+
+   if ((stream = ws2812_build(strips, count, order, &nbits)) == NULL)
+   {
+      PyErr_NoMemory();
+      goto done;
+   }
+
+   Py_BEGIN_ALLOW_THREADS // disable GIL
+   ws2812_send(stream, nbits);
+   Py_END_ALLOW_THREADS   // enable GIL
+
+   free(stream);
+   Py_INCREF(Py_None);
+   result = Py_None;
+
+done:
+   for (i=0; i<held; i++)
+      PyBuffer_Release(&views[i]);
+   Py_XDECREF(chanseq);
+   Py_XDECREF(dataseq);
+   return result;
+}
+
+// python function (humidity, temperature) = read_dht(channel, kind)
+static PyObject *py_read_dht(PyObject *self, PyObject *args)
+{
+   unsigned int gpio;
+   int channel, kind, result;
+   float humidity, temperature;
+
+   if (!PyArg_ParseTuple(args, "ii", &channel, &kind))
+      return NULL;
+
+   if (get_gpio_number(channel, &gpio))
+      return NULL;
+
+   if (kind != DHT11 && kind != DHT22)
+   {
+      PyErr_SetString(PyExc_ValueError, "kind must be DHT11 or DHT22");
+      return NULL;
+   }
+
+   if (mmap_gpio_mem())
+      return NULL;
+
+   if (check_gpio_priv())
+      return NULL;
+
+   Py_BEGIN_ALLOW_THREADS // disable GIL
+   result = dht_read(gpio, kind, &humidity, &temperature);
+   Py_END_ALLOW_THREADS   // enable GIL
+
+   // so that cleanup() resets the pin
+   gpio_direction[gpio] = INPUT;
+
+   if (result == 1)
+   {
+      PyErr_SetString(PyExc_RuntimeError, "No response from DHT sensor");
+      return NULL;
+   } else if (result == 2) {
+      PyErr_SetString(PyExc_RuntimeError, "DHT sensor checksum error");
+      return NULL;
+   }
+   return Py_BuildValue("(dd)", (double)humidity, (double)temperature);
+}
+
+// python function set_direction_mask(mask, direction)
+static PyObject *py_set_direction_mask(PyObject *self, PyObject *args)
+{
+   unsigned long long mask;
+   int direction;
+   unsigned int gpio;
+
+   if (!PyArg_ParseTuple(args, "Ki", &mask, &direction))
+      return NULL;
+
+   if (direction != INPUT && direction != OUTPUT) {
+      PyErr_SetString(PyExc_ValueError, "An invalid direction was passed to set_direction_mask()");
+      return NULL;
+   }
+
+   if (mask >> 54) {
+      PyErr_SetString(PyExc_ValueError, "mask contains a GPIO that does not exist");
+      return NULL;
+   }
+
+   // only channels that setup() has already claimed can be turned around
+   for (gpio=0; gpio<54; gpio++) {
+      if ((mask & (1ULL << gpio)) && gpio_direction[gpio] != INPUT && gpio_direction[gpio] != OUTPUT) {
+         PyErr_SetString(PyExc_RuntimeError, "You must setup() the GPIO channel first");
+         return NULL;
+      }
+   }
+
+   if (check_gpio_priv())
+      return NULL;
+
+   if (set_direction_gpio_mask(mask, direction)) {
+      for (gpio=0; gpio<54; gpio++)
+         if (mask & (1ULL << gpio))
+            set_direction_gpio(gpio, direction);
+   }
+   for (gpio=0; gpio<54; gpio++)
+      if (mask & (1ULL << gpio))
+         gpio_direction[gpio] = direction;
+
+   Py_RETURN_NONE;
+}
+
+// python function state = snapshot()
+static PyObject *py_snapshot(PyObject *self, PyObject *args)
+{
+   struct gpio_snapshot snap;
+
+   if (mmap_gpio_mem())
+      return NULL;
+
+   if (check_gpio_priv())
+      return NULL;
+
+   if (snapshot_gpio(&snap))
+   {
+      PyErr_SetString(PyExc_RuntimeError, "snapshot() is not supported on this board");
+      return NULL;
+   }
+   return PyBytes_FromStringAndSize((char *)&snap, sizeof(snap));
+}
+
+// python function restore(state)
+static PyObject *py_restore(PyObject *self, PyObject *args)
+{
+   Py_buffer state;
+   struct gpio_snapshot snap;
+   int i;
+
+#if PY_MAJOR_VERSION > 2
+   if (!PyArg_ParseTuple(args, "y*", &state))
+#else
+   if (!PyArg_ParseTuple(args, "s*", &state))
+#endif
+      return NULL;
+
+   if (state.len != sizeof(snap))
+   {
+      PyBuffer_Release(&state);
+      PyErr_SetString(PyExc_ValueError, "state was not returned by snapshot()");
+      return NULL;
+   }
+   memcpy(&snap, state.buf, sizeof(snap));
+   PyBuffer_Release(&state);
+
+   if (mmap_gpio_mem())
+      return NULL;
+
+   if (check_gpio_priv())
+      return NULL;
+
+   restore_gpio(&snap);
+
+   // channels this program set up follow the restored functions - a channel
+   // restored to an ALT function is no longer ours to use
+   for (i=0; i<54; i++)
+   {
+      if (gpio_direction[i] == -1)
+         continue;
+      switch ((snap.fsel[i/10] >> ((i%10)*3)) & 7)
+      {
+         case 0 : gpio_direction[i] = INPUT;  break;
+         case 1 : gpio_direction[i] = OUTPUT; break;
+         default: gpio_direction[i] = -1;     break;
+      }
+   }
+   Py_RETURN_NONE;
+}
+
 // python function value = gpio_function(channel)
 static PyObject *py_gpio_function(PyObject *self, PyObject *args)
 {
@@ -963,16 +1630,30 @@ static const char moduledocstring[] = "GPIO functionality of a Raspberry Pi usin
 
 PyMethodDef rpi_gpio_methods[] = {
    {"setup", (PyCFunction)py_setup_channel, METH_VARARGS | METH_KEYWORDS, "Set up a GPIO channel or list of channels with a direction and (optional) pull/up down control\nchannel        - either board pin number or BCM number depending on which mode is set.\ndirection      - IN or OUT\n[pull_up_down] - PUD_OFF (default), PUD_UP or PUD_DOWN\n[initial]      - Initial value for an output channel"},
+   {"set_direction_mask", py_set_direction_mask, METH_VARARGS, "Switch channels that are already set up between IN and OUT, leaving the pull up/downs alone.  Each function select register is written at most once\nmask      - bit n set for BCM GPIO n, whichever numbering mode is set\ndirection - IN or OUT"},
    {"cleanup", (PyCFunction)py_cleanup, METH_VARARGS | METH_KEYWORDS, "Clean up by resetting all GPIO channels that have been used by this program to INPUT with no pullup/pulldown and no event detection\n[channel] - individual channel or list/tuple of channels to clean up.  Default - clean every channel that has been used."},
    {"output", py_output_gpio, METH_VARARGS, "Output to a GPIO channel or list of channels\nchannel - either board pin number or BCM number depending on which mode is set.\nvalue   - 0/1 or False/True or LOW/HIGH"},
    {"input", py_input_gpio, METH_VARARGS, "Input from a GPIO channel.  Returns HIGH=1=True or LOW=0=False\nchannel - either board pin number or BCM number depending on which mode is set."},
    {"setmode", py_setmode, METH_VARARGS, "Set up numbering mode to use for channels.\nBOARD - Use Raspberry Pi board numbers\nBCM   - Use Broadcom GPIO 00..nn numbers"},
    {"getmode", py_getmode, METH_VARARGS, "Get numbering mode used for channel numbers.\nReturns BOARD, BCM or None"},
-   {"add_event_detect", (PyCFunction)py_add_event_detect, METH_VARARGS | METH_KEYWORDS, "Enable edge detection events for a particular GPIO channel.\nchannel      - either board pin number or BCM number depending on which mode is set.\nedge         - RISING, FALLING or BOTH\n[callback]   - A callback function for the event (optional)\n[bouncetime] - Switch bounce timeout in ms for callback"},
+   {"add_event_detect", (PyCFunction)py_add_event_detect, METH_VARARGS | METH_KEYWORDS, "Enable edge detection events for a particular GPIO channel.\nchannel      - either board pin number or BCM number depending on which mode is set.\nedge         - RISING, FALLING or BOTH\n[callback]   - A callback function for the event (optional)\n[bouncetime] - Switch bounce timeout in ms for callback\n[debounce]   - Time in us the level must be stable before an event is reported (alternative to bouncetime)"},
    {"remove_event_detect", py_remove_event_detect, METH_VARARGS, "Remove edge detection for a particular GPIO channel\nchannel - either board pin number or BCM number depending on which mode is set."},
    {"event_detected", py_event_detected, METH_VARARGS, "Returns True if an edge has occurred on a given GPIO.  You need to enable edge detection using add_event_detect() first.\nchannel - either board pin number or BCM number depending on which mode is set."},
+   {"debounced_input", py_debounced_input, METH_VARARGS, "Return the settled level of a channel with debounced event detection.  Returns HIGH=1=True or LOW=0=False\nchannel - either board pin number or BCM number depending on which mode is set."},
    {"add_event_callback", (PyCFunction)py_add_event_callback, METH_VARARGS | METH_KEYWORDS, "Add a callback for an event already defined using add_event_detect()\nchannel      - either board pin number or BCM number depending on which mode is set.\ncallback     - a callback function"},
    {"wait_for_edge", (PyCFunction)py_wait_for_edge, METH_VARARGS | METH_KEYWORDS, "Wait for an edge.  Returns the channel number or None on timeout.\nchannel      - either board pin number or BCM number depending on which mode is set.\nedge         - RISING, FALLING or BOTH\n[bouncetime] - time allowed between calls to allow for switchbounce\n[timeout]    - timeout in ms"},
+   {"measure_frequency", (PyCFunction)py_measure_frequency, METH_VARARGS | METH_KEYWORDS, "Measure frequency, period and duty cycle of a signal over a time window.  Returns a dict with frequency (Hz), period_min/period_max/period_avg (us), duty_cycle (%) and edges\nchannel   - either board pin number or BCM number depending on which mode is set.\nwindow_ms - measurement window in ms"},
+   {"start_frequency", py_start_frequency, METH_VARARGS, "Start continuous frequency measurement on a GPIO channel\nchannel - either board pin number or BCM number depending on which mode is set."},
+   {"read_frequency", (PyCFunction)py_read_frequency, METH_VARARGS | METH_KEYWORDS, "Read the result of a continuous frequency measurement (see measure_frequency())\nchannel - either board pin number or BCM number depending on which mode is set.\n[reset] - start a new measurement period after reading"},
+   {"stop_frequency", py_stop_frequency, METH_VARARGS, "Stop continuous frequency measurement on a GPIO channel\nchannel - either board pin number or BCM number depending on which mode is set."},
+   {"start_recording", (PyCFunction)py_start_recording, METH_VARARGS | METH_KEYWORDS, "Record every edge on GPIO channels into a memory mapped ring buffer file (see RPi.GPIO.edgelog)\npath       - file to create\nchannel    - either board pin number or BCM number depending on which mode is set, or a list/tuple of them\n[capacity] - number of records kept (default 65536)"},
+   {"stop_recording", py_stop_recording, METH_NOARGS, "Stop recording edges and flush the file"},
+   {"pulse_in", (PyCFunction)py_pulse_in, METH_VARARGS | METH_KEYWORDS, "Measure the width of the next pulse on a GPIO channel.  Returns the width in ns or None on timeout\nchannel      - either board pin number or BCM number depending on which mode is set.\nlevel        - HIGH or LOW pulse\n[timeout_us] - timeout in us (default 1 s)"},
+   {"trigger_and_measure", (PyCFunction)py_trigger_and_measure, METH_VARARGS | METH_KEYWORDS, "Send a trigger pulse on an output and measure the answering pulse on an input (e.g. ultrasonic ranging).  Returns the width in ns or None on timeout\nout_channel  - output channel for the trigger pulse\nin_channel   - input channel for the answering pulse\n[level]      - HIGH (default) or LOW pulses\n[trigger_us] - width of the trigger pulse in us (default 10)\n[timeout_us] - timeout in us (default 1 s)"},
+   {"ws2812_write", (PyCFunction)py_ws2812_write, METH_VARARGS | METH_KEYWORDS, "Send pixel data to WS2812 (NeoPixel) LED strips.  Several strips are driven in parallel\nchannel - either board pin number or BCM number depending on which mode is set, or a list/tuple of them\ndata    - bytes with R, G, B for each LED, or a list/tuple of them (one per channel)\n[order] - order the strip expects the colours in (default 'GRB')"},
+   {"read_dht", py_read_dht, METH_VARARGS, "Read a DHT11 or DHT22 (AM2302) sensor.  Returns (humidity in %, temperature in degrees C)\nchannel - either board pin number or BCM number depending on which mode is set.\nkind    - DHT11 or DHT22"},
+   {"snapshot", py_snapshot, METH_NOARGS, "Save the function, output level and (Pi 4) pull up/down of every GPIO.  Returns an opaque state for restore()"},
+   {"restore", py_restore, METH_VARARGS, "Put every GPIO back the way it was when snapshot() was called.  Channels already set up become inputs or outputs to match\nstate - the value returned by snapshot()"},
    {"gpio_function", py_gpio_function, METH_VARARGS, "Return the current GPIO function (IN, OUT, PWM, SERIAL, I2C, SPI)\nchannel - either board pin number or BCM number depending on which mode is set."},
    {"setwarnings", py_setwarnings, METH_VARARGS, "Enable or disable warning messages"},
    {NULL, NULL, 0, NULL}
@@ -1051,6 +1732,86 @@ PyMODINIT_FUNC init_GPIO(void)
    Py_INCREF(&PWMType);
    PyModule_AddObject(module, "PWM", (PyObject*)&PWMType);
 
+   // Add Encoder class
+   if (Encoder_init_EncoderType() == NULL)
+#if PY_MAJOR_VERSION > 2
+      return NULL;
+#else
+      return;
+#endif
+   Py_INCREF(&EncoderType);
+   PyModule_AddObject(module, "Encoder", (PyObject*)&EncoderType);
+
+   // Add SoftSPI class
+   if (SoftSPI_init_SoftSPIType() == NULL)
+#if PY_MAJOR_VERSION > 2
+      return NULL;
+#else
+      return;
+#endif
+   Py_INCREF(&SoftSPIType);
+   PyModule_AddObject(module, "SoftSPI", (PyObject*)&SoftSPIType);
+
+   // Add SoftI2C class
+   if (SoftI2C_init_SoftI2CType() == NULL)
+#if PY_MAJOR_VERSION > 2
+      return NULL;
+#else
+      return;
+#endif
+   Py_INCREF(&SoftI2CType);
+   PyModule_AddObject(module, "SoftI2C", (PyObject*)&SoftI2CType);
+
+   // Add OneWire class
+   if (OneWire_init_OneWireType() == NULL)
+#if PY_MAJOR_VERSION > 2
+      return NULL;
+#else
+      return;
+#endif
+   Py_INCREF(&OneWireType);
+   PyModule_AddObject(module, "OneWire", (PyObject*)&OneWireType);
+
+   // Add Bus class
+   if (Bus_init_BusType() == NULL)
+#if PY_MAJOR_VERSION > 2
+      return NULL;
+#else
+      return;
+#endif
+   Py_INCREF(&BusType);
+   PyModule_AddObject(module, "Bus", (PyObject*)&BusType);
+
+   // Add Keypad class
+   if (Keypad_init_KeypadType() == NULL)
+#if PY_MAJOR_VERSION > 2
+      return NULL;
+#else
+      return;
+#endif
+   Py_INCREF(&KeypadType);
+   PyModule_AddObject(module, "Keypad", (PyObject*)&KeypadType);
+
+   // Add Stepper class
+   if (Stepper_init_StepperType() == NULL)
+#if PY_MAJOR_VERSION > 2
+      return NULL;
+#else
+      return;
+#endif
+   Py_INCREF(&StepperType);
+   PyModule_AddObject(module, "Stepper", (PyObject*)&StepperType);
+
+   // Add Servo class
+   if (Servo_init_ServoType() == NULL)
+#if PY_MAJOR_VERSION > 2
+      return NULL;
+#else
+      return;
+#endif
+   Py_INCREF(&ServoType);
+   PyModule_AddObject(module, "Servo", (PyObject*)&ServoType);
+
    if (!PyEval_ThreadsInitialized())
       PyEval_InitThreads();
 
@@ -0,0 +1,282 @@
+/*
+Copyright (c) 2020 GC2
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+of the Software, and to permit persons to whom the Software is furnished to do
+so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "Python.h"
+#include "keypad.h"
+#include "py_keypad.h"
+#include "common.h"
+#include "c_gpio.h"
+
+typedef struct
+{
+    PyObject_HEAD
+    struct keypad *keypad;
+    int nrows, ncols;
+} KeypadObject;
+
+// convert a list/tuple of channels to gpio numbers
+// returns the number of channels or -1 with an exception set
+static int get_lines(PyObject *list, const char *name, unsigned int *gpio, uint64_t *used)
+{
+    PyObject *seq;
+    int count, channel, i;
+
+    if ((seq = PySequence_Fast(list, "rows and cols must be lists/tuples of channels")) == NULL)
+        return -1;
+
+    count = PySequence_Fast_GET_SIZE(seq);
+    if (count < 1 || count > KEYPAD_MAX_LINES)
+    {
+        Py_DECREF(seq);
+        PyErr_Format(PyExc_ValueError, "A keypad must have between 1 and %d %s", KEYPAD_MAX_LINES, name);
+        return -1;
+    }
+
+    for (i=0; i<count; i++)
+    {
+#if PY_MAJOR_VERSION >= 3
+        channel = (int)PyLong_AsLong(PySequence_Fast_GET_ITEM(seq, i));
+#else
+        channel = (int)PyInt_AsLong(PySequence_Fast_GET_ITEM(seq, i));
+#endif
+        if (PyErr_Occurred() || get_gpio_number(channel, &gpio[i]))
+        {
+            Py_DECREF(seq);
+            return -1;
+        }
+        if (*used & (1ULL << gpio[i]))
+        {
+            Py_DECREF(seq);
+            PyErr_SetString(PyExc_ValueError, "A channel appears more than once in the keypad");
+            return -1;
+        }
+        *used |= 1ULL << gpio[i];
+    }
+    Py_DECREF(seq);
+    return count;
+}
+
+// python method Keypad.__init__(self, rows, cols, interval_ms=10, debounce=2)
+static int Keypad_init(KeypadObject *self, PyObject *args, PyObject *kwds)
+{
+    PyObject *rowlist, *collist;
+    unsigned int rows[KEYPAD_MAX_LINES], cols[KEYPAD_MAX_LINES];
+    uint64_t used = 0;
+    int nrows, ncols, i;
+    int interval = 10;
+    int debounce = 2;
+    static char *kwlist[] = {"rows", "cols", "interval_ms", "debounce", NULL};
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "OO|ii", kwlist, &rowlist, &collist, &interval, &debounce))
+        return -1;
+
+    if ((nrows = get_lines(rowlist, "rows", rows, &used)) < 0 ||
+        (ncols = get_lines(collist, "cols", cols, &used)) < 0)
+        return -1;
+
+    if (interval <= 0 || debounce <= 0)
+    {
+        PyErr_SetString(PyExc_ValueError, "interval_ms and debounce must be greater than 0");
+        return -1;
+    }
+
+    if (mmap_gpio_mem())
+        return -1;
+
+    if (self->keypad != NULL)
+    {
+        keypad_free(self->keypad);
+        self->keypad = NULL;
+    }
+
+    // rows are released (inputs with the latch low) until scanned, columns are pulled up
+    for (i=0; i<nrows; i++)
+    {
+        output_gpio(rows[i], 0);
+        setup_gpio(rows[i], INPUT, PUD_OFF);
+        gpio_direction[rows[i]] = INPUT;
+    }
+    for (i=0; i<ncols; i++)
+    {
+        setup_gpio(cols[i], INPUT, PUD_UP);
+        gpio_direction[cols[i]] = INPUT;
+    }
+
+    if ((self->keypad = keypad_start(rows, nrows, cols, ncols, interval * 1000, debounce)) == NULL)
+    {
+        PyErr_SetString(PyExc_RuntimeError, "Failed to start the keypad scan thread");
+        return -1;
+    }
+    self->nrows = nrows;
+    self->ncols = ncols;
+    return 0;
+}
+
+static int check_keypad(KeypadObject *self)
+{
+    if (self->keypad == NULL)
+    {
+        PyErr_SetString(PyExc_RuntimeError, "Keypad object not initialised");
+        return 1;
+    }
+    return 0;
+}
+
+// python method Keypad.get_event(self, timeout=None)
+static PyObject *Keypad_get_event(KeypadObject *self, PyObject *args, PyObject *kwds)
+{
+    PyObject *timeout = Py_None;
+    struct keypad_event ev;
+    int timeout_ms = -1;
+    int result;
+    double seconds;
+    static char *kwlist[] = {"timeout", NULL};
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "|O", kwlist, &timeout))
+        return NULL;
+
+    if (check_keypad(self))
+        return NULL;
+
+    if (timeout != Py_None)
+    {
+        seconds = PyFloat_AsDouble(timeout);
+        if (PyErr_Occurred())
+            return NULL;
+        if (seconds < 0.0)
+        {
+            PyErr_SetString(PyExc_ValueError, "timeout must not be negative");
+            return NULL;
+        }
+        timeout_ms = (int)(seconds * 1000.0);
+    }
+
+    Py_BEGIN_ALLOW_THREADS // disable GIL
+    result = keypad_get_event(self->keypad, &ev, timeout_ms);
+    Py_END_ALLOW_THREADS   // enable GIL
+
+    if (result < 0)
+    {
+        PyErr_SetString(PyExc_RuntimeError, "The keypad has been stopped");
+        return NULL;
+    }
+    if (result == 0)
+        Py_RETURN_NONE;
+    return Py_BuildValue("(iiO)", ev.row, ev.col, ev.pressed ? Py_True : Py_False);
+}
+
+// python method Keypad.is_pressed(self, row, col)
+static PyObject *Keypad_is_pressed(KeypadObject *self, PyObject *args)
+{
+    int row, col;
+
+    if (!PyArg_ParseTuple(args, "ii", &row, &col))
+        return NULL;
+
+    if (check_keypad(self))
+        return NULL;
+
+    if (row < 0 || row >= self->nrows || col < 0 || col >= self->ncols)
+    {
+        PyErr_SetString(PyExc_ValueError, "row or col out of range");
+        return NULL;
+    }
+
+    return PyBool_FromLong(keypad_pressed(self->keypad, row, col));
+}
+
+// python method Keypad.stop(self)
+static PyObject *Keypad_stop(KeypadObject *self, PyObject *args)
+{
+    if (check_keypad(self))
+        return NULL;
+
+    keypad_stop(self->keypad);
+    Py_RETURN_NONE;
+}
+
+// deallocation method
+static void Keypad_dealloc(KeypadObject *self)
+{
+    if (self->keypad != NULL)
+        keypad_free(self->keypad);
+    Py_TYPE(self)->tp_free((PyObject*)self);
+}
+
+static PyMethodDef
+Keypad_methods[] = {
+   { "get_event", (PyCFunction)Keypad_get_event, METH_VARARGS | METH_KEYWORDS, "Wait for the next key event.  Returns (row, col, pressed) or None on timeout\n[timeout] - seconds to wait (default None waits forever)" },
+   { "is_pressed", (PyCFunction)Keypad_is_pressed, METH_VARARGS, "Return whether a key is currently held down\nrow - row index\ncol - column index" },
+   { "stop", (PyCFunction)Keypad_stop, METH_NOARGS, "Stop scanning the keypad" },
+   { NULL }
+};
+
+PyTypeObject KeypadType = {
+   PyVarObject_HEAD_INIT(NULL,0)
+   "RPi.GPIO.Keypad",         // tp_name
+   sizeof(KeypadObject),      // tp_basicsize
+   0,                         // tp_itemsize
+   (destructor)Keypad_dealloc, // tp_dealloc
+   0,                         // tp_print
+   0,                         // tp_getattr
+   0,                         // tp_setattr
+   0,                         // tp_compare
+   0,                         // tp_repr
+   0,                         // tp_as_number
+   0,                         // tp_as_sequence
+   0,                         // tp_as_mapping
+   0,                         // tp_hash
+   0,                         // tp_call
+   0,                         // tp_str
+   0,                         // tp_getattro
+   0,                         // tp_setattro
+   0,                         // tp_as_buffer
+   Py_TPFLAGS_DEFAULT | Py_TPFLAGS_BASETYPE, // tp_flag
+   "Matrix keypad scanner class\nrows          - list/tuple of row channels (pulled low in turn, released otherwise)\ncols          - list/tuple of column channels (pulled up)\n[interval_ms] - scan interval in ms (default 10)\n[debounce]    - consecutive scans a change must persist for (default 2)",    // tp_doc
+   0,                         // tp_traverse
+   0,                         // tp_clear
+   0,                         // tp_richcompare
+   0,                         // tp_weaklistoffset
+   0,                         // tp_iter
+   0,                         // tp_iternext
+   Keypad_methods,            // tp_methods
+   0,                         // tp_members
+   0,                         // tp_getset
+   0,                         // tp_base
+   0,                         // tp_dict
+   0,                         // tp_descr_get
+   0,                         // tp_descr_set
+   0,                         // tp_dictoffset
+   (initproc)Keypad_init,     // tp_init
+   0,                         // tp_alloc
+   0,                         // tp_new
+};
+
+PyTypeObject *Keypad_init_KeypadType(void)
+{
+   // Fill in some slots in the type, and make it ready
+   KeypadType.tp_new = PyType_GenericNew;
+   if (PyType_Ready(&KeypadType) < 0)
+      return NULL;
+
+   return &KeypadType;
+}
@@ -0,0 +1,336 @@
+/*
+Copyright (c) 2020 GC2
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+of the Software, and to permit persons to whom the Software is furnished to do
+so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "Python.h"
+#include "onewire.h"
+#include "py_onewire.h"
+#include "common.h"
+#include "c_gpio.h"
+
+// most devices returned by a single search()
+#define MAX_DEVICES 64
+
+typedef struct
+{
+    PyObject_HEAD
+    struct onewire ow;
+    int ready;
+} OneWireObject;
+
+// python method OneWire.__init__(self, channel, realtime=False)
+static int OneWire_init(OneWireObject *self, PyObject *args, PyObject *kwds)
+{
+    int channel;
+    unsigned int gpio;
+    int realtime = 0;
+    static char *kwlist[] = {"channel", "realtime", NULL};
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "i|i", kwlist, &channel, &realtime))
+        return -1;
+
+    if (get_gpio_number(channel, &gpio))
+        return -1;
+
+    if (mmap_gpio_mem())
+        return -1;
+
+    self->ow.gpio = gpio;
+    self->ow.realtime = realtime;
+    onewire_setup(&self->ow);
+
+    // so that cleanup() resets the pin
+    gpio_direction[gpio] = INPUT;
+    self->ready = 1;
+    return 0;
+}
+
+static int check_ready(OneWireObject *self)
+{
+    if (!self->ready)
+    {
+        PyErr_SetString(PyExc_RuntimeError, "OneWire object not initialised");
+        return 1;
+    }
+    return check_gpio_priv();
+}
+
+// python method OneWire.reset(self)
+static PyObject *OneWire_reset(OneWireObject *self, PyObject *args)
+{
+    int presence;
+
+    if (check_ready(self))
+        return NULL;
+
+    Py_BEGIN_ALLOW_THREADS // disable GIL
+    presence = onewire_reset(&self->ow);
+    Py_END_ALLOW_THREADS   // enable GIL
+
+    return PyBool_FromLong(presence);
+}
+
+// python method OneWire.read_bit(self)
+static PyObject *OneWire_read_bit(OneWireObject *self, PyObject *args)
+{
+    int bit;
+
+    if (check_ready(self))
+        return NULL;
+
+    Py_BEGIN_ALLOW_THREADS // disable GIL
+    bit = onewire_read_bit(&self->ow);
+    Py_END_ALLOW_THREADS   // enable GIL
+
+    return Py_BuildValue("i", bit);
+}
+
+// python method OneWire.write_bit(self, bit)
+static PyObject *OneWire_write_bit(OneWireObject *self, PyObject *args)
+{
+    int bit;
+
+    if (!PyArg_ParseTuple(args, "i", &bit))
+        return NULL;
+
+    if (check_ready(self))
+        return NULL;
+
+    Py_BEGIN_ALLOW_THREADS // disable GIL
+    onewire_write_bit(&self->ow, bit != 0);
+    Py_END_ALLOW_THREADS   // enable GIL
+
+    Py_RETURN_NONE;
+}
+
+static PyObject *do_read(OneWireObject *self, Py_ssize_t len)
+{
+    PyObject *result;
+    unsigned char *buf;
+
+    if (check_ready(self))
+        return NULL;
+
+    if ((result = PyBytes_FromStringAndSize(NULL, len)) == NULL)
+        return NULL;
+    buf = (unsigned char *)PyBytes_AS_STRING(result);
+
+    Py_BEGIN_ALLOW_THREADS // disable GIL
+    onewire_read(&self->ow, buf, len);
+    Py_END_ALLOW_THREADS   // enable GIL
+
+    return result;
+}
+
+static PyObject *do_write(OneWireObject *self, const unsigned char *buf, Py_ssize_t len)
+{
+    if (check_ready(self))
+        return NULL;
+
+    Py_BEGIN_ALLOW_THREADS // disable GIL
+    onewire_write(&self->ow, buf, len);
+    Py_END_ALLOW_THREADS   // enable GIL
+
+    Py_RETURN_NONE;
+}
+
+// python method OneWire.read_byte(self)
+static PyObject *OneWire_read_byte(OneWireObject *self, PyObject *args)
+{
+    PyObject *data, *result;
+
+    if ((data = do_read(self, 1)) == NULL)
+        return NULL;
+    result = Py_BuildValue("i", (unsigned char)PyBytes_AS_STRING(data)[0]);
+    Py_DECREF(data);
+    return result;
+}
+
+// python method OneWire.write_byte(self, value)
+static PyObject *OneWire_write_byte(OneWireObject *self, PyObject *args)
+{
+    int value;
+    unsigned char byte;
+
+    if (!PyArg_ParseTuple(args, "i", &value))
+        return NULL;
+
+    if (value < 0 || value > 255)
+    {
+        PyErr_SetString(PyExc_ValueError, "value must be between 0 and 255");
+        return NULL;
+    }
+
+    byte = value;
+    return do_write(self, &byte, 1);
+}
+
+// python method OneWire.read(self, length)
+static PyObject *OneWire_read(OneWireObject *self, PyObject *args)
+{
+    Py_ssize_t len;
+
+    if (!PyArg_ParseTuple(args, "n", &len))
+        return NULL;
+
+    if (len < 0)
+    {
+        PyErr_SetString(PyExc_ValueError, "length must not be negative");
+        return NULL;
+    }
+
+    return do_read(self, len);
+}
+
+// python method OneWire.write(self, data)
+static PyObject *OneWire_write(OneWireObject *self, PyObject *args)
+{
+    Py_buffer data;
+    PyObject *result;
+
+#if PY_MAJOR_VERSION > 2
+    if (!PyArg_ParseTuple(args, "y*", &data))
+#else
+    if (!PyArg_ParseTuple(args, "s*", &data))
+#endif
+        return NULL;
+
+    result = do_write(self, (const unsigned char *)data.buf, data.len);
+    PyBuffer_Release(&data);
+    return result;
+}
+
+// python method OneWire.search(self)
+static PyObject *OneWire_search(OneWireObject *self, PyObject *args)
+{
+    unsigned char roms[MAX_DEVICES][8];
+    PyObject *list, *rom;
+    int count, i;
+
+    if (check_ready(self))
+        return NULL;
+
+    Py_BEGIN_ALLOW_THREADS // disable GIL
+    count = onewire_search(&self->ow, roms, MAX_DEVICES);
+    Py_END_ALLOW_THREADS   // enable GIL
+
+    if (count < 0)
+    {
+        PyErr_SetString(PyExc_RuntimeError, "1-Wire ROM search failed");
+        return NULL;
+    }
+
+    if ((list = PyList_New(count)) == NULL)
+        return NULL;
+    for (i=0; i<count; i++)
+    {
+        if ((rom = PyBytes_FromStringAndSize((char *)roms[i], 8)) == NULL)
+        {
+            Py_DECREF(list);
+            return NULL;
+        }
+        PyList_SET_ITEM(list, i, rom);
+    }
+    return list;
+}
+
+// python method OneWire.crc8(data)
+static PyObject *OneWire_crc8(PyObject *cls, PyObject *args)
+{
+    Py_buffer data;
+    unsigned char crc;
+
+#if PY_MAJOR_VERSION > 2
+    if (!PyArg_ParseTuple(args, "y*", &data))
+#else
+    if (!PyArg_ParseTuple(args, "s*", &data))
+#endif
+        return NULL;
+
+    crc = onewire_crc8((const unsigned char *)data.buf, data.len);
+    PyBuffer_Release(&data);
+    return Py_BuildValue("i", crc);
+}
+
+static PyMethodDef
+OneWire_methods[] = {
+   { "reset", (PyCFunction)OneWire_reset, METH_NOARGS, "Send a reset pulse\nReturns True if a device answered with a presence pulse" },
+   { "read_bit", (PyCFunction)OneWire_read_bit, METH_NOARGS, "Read a single time slot" },
+   { "write_bit", (PyCFunction)OneWire_write_bit, METH_VARARGS, "Write a single time slot\nbit - 0 or 1" },
+   { "read_byte", (PyCFunction)OneWire_read_byte, METH_NOARGS, "Read a byte" },
+   { "write_byte", (PyCFunction)OneWire_write_byte, METH_VARARGS, "Write a byte\nvalue - 0..255" },
+   { "read", (PyCFunction)OneWire_read, METH_VARARGS, "Read bytes\nlength - number of bytes" },
+   { "write", (PyCFunction)OneWire_write, METH_VARARGS, "Write bytes\ndata - bytes to send" },
+   { "search", (PyCFunction)OneWire_search, METH_NOARGS, "Search the bus\nReturns a list of 8 byte ROM codes" },
+   { "crc8", (PyCFunction)OneWire_crc8, METH_VARARGS | METH_STATIC, "Calculate the Dallas/Maxim CRC8 of some bytes\ndata - bytes" },
+   { NULL }
+};
+
+PyTypeObject OneWireType = {
+   PyVarObject_HEAD_INIT(NULL,0)
+   "RPi.GPIO.OneWire",        // tp_name
+   sizeof(OneWireObject),     // tp_basicsize
+   0,                         // tp_itemsize
+   0,                         // tp_dealloc
+   0,                         // tp_print
+   0,                         // tp_getattr
+   0,                         // tp_setattr
+   0,                         // tp_compare
+   0,                         // tp_repr
+   0,                         // tp_as_number
+   0,                         // tp_as_sequence
+   0,                         // tp_as_mapping
+   0,                         // tp_hash
+   0,                         // tp_call
+   0,                         // tp_str
+   0,                         // tp_getattro
+   0,                         // tp_setattro
+   0,                         // tp_as_buffer
+   Py_TPFLAGS_DEFAULT | Py_TPFLAGS_BASETYPE, // tp_flag
+   "1-Wire bus master class\nchannel    - the channel with the bus pull up\n[realtime] - run time slots at SCHED_FIFO priority if permitted (default False)",    // tp_doc
+   0,                         // tp_traverse
+   0,                         // tp_clear
+   0,                         // tp_richcompare
+   0,                         // tp_weaklistoffset
+   0,                         // tp_iter
+   0,                         // tp_iternext
+   OneWire_methods,           // tp_methods
+   0,                         // tp_members
+   0,                         // tp_getset
+   0,                         // tp_base
+   0,                         // tp_dict
+   0,                         // tp_descr_get
+   0,                         // tp_descr_set
+   0,                         // tp_dictoffset
+   (initproc)OneWire_init,    // tp_init
+   0,                         // tp_alloc
+   0,                         // tp_new
+};
+
+PyTypeObject *OneWire_init_OneWireType(void)
+{
+   // Fill in some slots in the type, and make it ready
+   OneWireType.tp_new = PyType_GenericNew;
+   if (PyType_Ready(&OneWireType) < 0)
+      return NULL;
+
+   return &OneWireType;
+}
@@ -22,6 +22,7 @@ SOFTWARE.
 
 #include "Python.h"
 #include "soft_pwm.h"
+#include "servo.h"
 #include "py_pwm.h"
 #include "common.h"
 #include "c_gpio.h"
@@ -54,6 +55,12 @@ static int PWM_init(PWMObject *self, PyObject *args, PyObject *kwds)
         return -1;
     }
 
+    if (servo_exists(self->gpio))
+    {
+        PyErr_SetString(PyExc_RuntimeError, "A Servo object already exists for this GPIO channel");
+        return -1;
+    }
+
     // ensure channel set as output
     if (gpio_direction[self->gpio] != OUTPUT)
     {
@@ -0,0 +1,196 @@
+/*
+Copyright (c) 2013-2018 Ben Croston
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+of the Software, and to permit persons to whom the Software is furnished to do
+so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "Python.h"
+#include "servo.h"
+#include "soft_pwm.h"
+#include "py_servo.h"
+#include "common.h"
+#include "c_gpio.h"
+
+typedef struct
+{
+    PyObject_HEAD
+    unsigned int gpio;
+    int ready;
+    int started;    // this object owns the pulses on gpio
+} ServoObject;
+
+static int check_width(int width)
+{
+    if (width < 0 || width > SERVO_MAX_WIDTH)
+    {
+        PyErr_Format(PyExc_ValueError, "pulse_us must have a value from 0 to %d", SERVO_MAX_WIDTH);
+        return 1;
+    }
+    return 0;
+}
+
+// python method Servo.__init__(self, channel)
+static int Servo_init(ServoObject *self, PyObject *args, PyObject *kwds)
+{
+    int channel;
+
+    if (!PyArg_ParseTuple(args, "i", &channel))
+        return -1;
+
+    // convert channel to gpio
+    if (get_gpio_number(channel, &(self->gpio)))
+        return -1;
+
+    if (servo_exists(self->gpio) || pwm_exists(self->gpio))
+    {
+        PyErr_SetString(PyExc_RuntimeError, "A PWM or Servo object already exists for this GPIO channel");
+        return -1;
+    }
+
+    // ensure channel set as output
+    if (gpio_direction[self->gpio] != OUTPUT)
+    {
+        PyErr_SetString(PyExc_RuntimeError, "You must setup() the GPIO channel as an output first");
+        return -1;
+    }
+
+    self->ready = 1;
+    return 0;
+}
+
+// python method Servo.start(self, pulse_us)
+static PyObject *Servo_start(ServoObject *self, PyObject *args)
+{
+    int width;
+    int result;
+
+    if (!PyArg_ParseTuple(args, "i", &width))
+        return NULL;
+
+    if (!self->ready)
+    {
+        PyErr_SetString(PyExc_RuntimeError, "Servo object not initialised");
+        return NULL;
+    }
+
+    if (check_width(width))
+        return NULL;
+
+    if ((result = servo_start(self->gpio, width)) == 1)
+    {
+        PyErr_SetString(PyExc_RuntimeError, "The servo has already been started");
+        return NULL;
+    } else if (result == 2) {
+        PyErr_SetString(PyExc_RuntimeError, "Failed to start the servo thread");
+        return NULL;
+    }
+    self->started = 1;
+    Py_RETURN_NONE;
+}
+
+// python method Servo.set_pulse_width(self, pulse_us)
+static PyObject *Servo_set_pulse_width(ServoObject *self, PyObject *args)
+{
+    int width;
+
+    if (!PyArg_ParseTuple(args, "i", &width))
+        return NULL;
+
+    if (check_width(width))
+        return NULL;
+
+    servo_set_width(self->gpio, width);
+    Py_RETURN_NONE;
+}
+
+// python method Servo.stop(self)
+static PyObject *Servo_stop(ServoObject *self, PyObject *args)
+{
+    if (self->started)
+        servo_stop(self->gpio);
+    self->started = 0;
+    Py_RETURN_NONE;
+}
+
+// deallocation method
+static void Servo_dealloc(ServoObject *self)
+{
+    if (self->started)
+        servo_stop(self->gpio);
+    Py_TYPE(self)->tp_free((PyObject*)self);
+}
+
+static PyMethodDef
+Servo_methods[] = {
+   { "start", (PyCFunction)Servo_start, METH_VARARGS, "Start sending servo pulses every 20 ms\npulse_us - pulse width in us (typically 1000 to 2000, 0 for no pulses)" },
+   { "set_pulse_width", (PyCFunction)Servo_set_pulse_width, METH_VARARGS, "Change the pulse width from the next frame\npulse_us - pulse width in us (0 for no pulses)" },
+   { "stop", (PyCFunction)Servo_stop, METH_NOARGS, "Stop sending servo pulses" },
+   { NULL }
+};
+
+PyTypeObject ServoType = {
+   PyVarObject_HEAD_INIT(NULL,0)
+   "RPi.GPIO.Servo",          // tp_name
+   sizeof(ServoObject),       // tp_basicsize
+   0,                         // tp_itemsize
+   (destructor)Servo_dealloc, // tp_dealloc
+   0,                         // tp_print
+   0,                         // tp_getattr
+   0,                         // tp_setattr
+   0,                         // tp_compare
+   0,                         // tp_repr
+   0,                         // tp_as_number
+   0,                         // tp_as_sequence
+   0,                         // tp_as_mapping
+   0,                         // tp_hash
+   0,                         // tp_call
+   0,                         // tp_str
+   0,                         // tp_getattro
+   0,                         // tp_setattro
+   0,                         // tp_as_buffer
+   Py_TPFLAGS_DEFAULT | Py_TPFLAGS_BASETYPE, // tp_flag
+   "RC servo class - all servos share one thread and a 20 ms frame\nchannel - either board pin number or BCM number depending on which mode is set.",    // tp_doc
+   0,                         // tp_traverse
+   0,                         // tp_clear
+   0,                         // tp_richcompare
+   0,                         // tp_weaklistoffset
+   0,                         // tp_iter
+   0,                         // tp_iternext
+   Servo_methods,             // tp_methods
+   0,                         // tp_members
+   0,                         // tp_getset
+   0,                         // tp_base
+   0,                         // tp_dict
+   0,                         // tp_descr_get
+   0,                         // tp_descr_set
+   0,                         // tp_dictoffset
+   (initproc)Servo_init,      // tp_init
+   0,                         // tp_alloc
+   0,                         // tp_new
+};
+
+PyTypeObject *Servo_init_ServoType(void)
+{
+   // Fill in some slots in the type, and make it ready
+   ServoType.tp_new = PyType_GenericNew;
+   if (PyType_Ready(&ServoType) < 0)
+      return NULL;
+
+   return &ServoType;
+}
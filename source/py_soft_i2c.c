@@ -0,0 +1,243 @@
+/*
+Copyright (c) 2020 GC2
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+of the Software, and to permit persons to whom the Software is furnished to do
+so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "Python.h"
+#include "soft_i2c.h"
+#include "py_soft_i2c.h"
+#include "common.h"
+#include "c_gpio.h"
+
+typedef struct
+{
+    PyObject_HEAD
+    struct soft_i2c i2c;
+    int ready;
+} SoftI2CObject;
+
+// python method SoftI2C.__init__(self, sda, scl, freq=100000)
+static int SoftI2C_init(SoftI2CObject *self, PyObject *args, PyObject *kwds)
+{
+    int sda_channel, scl_channel;
+    unsigned int sda, scl;
+    int freq = 100000;
+    static char *kwlist[] = {"sda", "scl", "freq", NULL};
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "ii|i", kwlist, &sda_channel, &scl_channel, &freq))
+        return -1;
+
+    if (get_gpio_number(sda_channel, &sda) || get_gpio_number(scl_channel, &scl))
+        return -1;
+
+    if (sda == scl)
+    {
+        PyErr_SetString(PyExc_ValueError, "sda and scl must be different channels");
+        return -1;
+    }
+
+    if (freq <= 0)
+    {
+        PyErr_SetString(PyExc_ValueError, "freq must be greater than 0");
+        return -1;
+    }
+
+    if (mmap_gpio_mem())
+        return -1;
+
+    self->i2c.sda = sda;
+    self->i2c.scl = scl;
+    self->i2c.half_period = 500000000UL / freq;
+    soft_i2c_setup(&self->i2c);
+
+    // so that cleanup() resets the pins
+    gpio_direction[sda] = INPUT;
+    gpio_direction[scl] = INPUT;
+    self->ready = 1;
+    return 0;
+}
+
+static int do_transfer(SoftI2CObject *self, int addr, const unsigned char *wbuf, Py_ssize_t wlen, unsigned char *rbuf, Py_ssize_t rlen)
+{
+    int result;
+
+    if (!self->ready)
+    {
+        PyErr_SetString(PyExc_RuntimeError, "SoftI2C object not initialised");
+        return -1;
+    }
+
+    if (check_gpio_priv())
+        return -1;
+
+    if (addr < 0 || addr > 127)
+    {
+        PyErr_SetString(PyExc_ValueError, "addr must be a 7 bit address");
+        return -1;
+    }
+
+    Py_BEGIN_ALLOW_THREADS // disable GIL
+    result = soft_i2c_transfer(&self->i2c, addr, wbuf, wlen, rbuf, rlen);
+    Py_END_ALLOW_THREADS   // enable GIL
+
+    if (result == 1)
+    {
+        PyErr_Format(PyExc_RuntimeError, "No acknowledge from device 0x%02x", addr);
+        return -1;
+    } else if (result == 2) {
+        PyErr_SetString(PyExc_RuntimeError, "Timed out waiting for SCL to be released");
+        return -1;
+    }
+    return 0;
+}
+
+static PyObject *do_write_read(SoftI2CObject *self, int addr, Py_buffer *data, Py_ssize_t len)
+{
+    PyObject *result;
+
+    if (len < 0)
+    {
+        PyErr_SetString(PyExc_ValueError, "length must not be negative");
+        return NULL;
+    }
+
+    if ((result = PyBytes_FromStringAndSize(NULL, len)) == NULL)
+        return NULL;
+
+    if (do_transfer(self, addr, data ? (const unsigned char *)data->buf : NULL, data ? data->len : 0,
+                    (unsigned char *)PyBytes_AS_STRING(result), len))
+    {
+        Py_DECREF(result);
+        return NULL;
+    }
+    return result;
+}
+
+// python method SoftI2C.write(self, addr, data)
+static PyObject *SoftI2C_write(SoftI2CObject *self, PyObject *args)
+{
+    int addr;
+    Py_buffer data;
+    int result;
+
+#if PY_MAJOR_VERSION > 2
+    if (!PyArg_ParseTuple(args, "iy*", &addr, &data))
+#else
+    if (!PyArg_ParseTuple(args, "is*", &addr, &data))
+#endif
+        return NULL;
+
+    result = do_transfer(self, addr, (const unsigned char *)data.buf, data.len, NULL, 0);
+    PyBuffer_Release(&data);
+    if (result)
+        return NULL;
+    Py_RETURN_NONE;
+}
+
+// python method SoftI2C.read(self, addr, length)
+static PyObject *SoftI2C_read(SoftI2CObject *self, PyObject *args)
+{
+    int addr;
+    Py_ssize_t len;
+
+    if (!PyArg_ParseTuple(args, "in", &addr, &len))
+        return NULL;
+
+    return do_write_read(self, addr, NULL, len);
+}
+
+// python method SoftI2C.write_read(self, addr, data, length)
+static PyObject *SoftI2C_write_read(SoftI2CObject *self, PyObject *args)
+{
+    int addr;
+    Py_buffer data;
+    Py_ssize_t len;
+    PyObject *result;
+
+#if PY_MAJOR_VERSION > 2
+    if (!PyArg_ParseTuple(args, "iy*n", &addr, &data, &len))
+#else
+    if (!PyArg_ParseTuple(args, "is*n", &addr, &data, &len))
+#endif
+        return NULL;
+
+    result = do_write_read(self, addr, &data, len);
+    PyBuffer_Release(&data);
+    return result;
+}
+
+static PyMethodDef
+SoftI2C_methods[] = {
+   { "write", (PyCFunction)SoftI2C_write, METH_VARARGS, "Write bytes to a device\naddr - 7 bit device address\ndata - bytes to send" },
+   { "read", (PyCFunction)SoftI2C_read, METH_VARARGS, "Read bytes from a device\naddr   - 7 bit device address\nlength - number of bytes" },
+   { "write_read", (PyCFunction)SoftI2C_write_read, METH_VARARGS, "Write bytes then read bytes after a repeated start\naddr   - 7 bit device address\ndata   - bytes to send\nlength - number of bytes to read" },
+   { NULL }
+};
+
+PyTypeObject SoftI2CType = {
+   PyVarObject_HEAD_INIT(NULL,0)
+   "RPi.GPIO.SoftI2C",        // tp_name
+   sizeof(SoftI2CObject),     // tp_basicsize
+   0,                         // tp_itemsize
+   0,                         // tp_dealloc
+   0,                         // tp_print
+   0,                         // tp_getattr
+   0,                         // tp_setattr
+   0,                         // tp_compare
+   0,                         // tp_repr
+   0,                         // tp_as_number
+   0,                         // tp_as_sequence
+   0,                         // tp_as_mapping
+   0,                         // tp_hash
+   0,                         // tp_call
+   0,                         // tp_str
+   0,                         // tp_getattro
+   0,                         // tp_setattro
+   0,                         // tp_as_buffer
+   Py_TPFLAGS_DEFAULT | Py_TPFLAGS_BASETYPE, // tp_flag
+   "Bit-banged I2C master class\nsda, scl - channels\n[freq]   - SCL frequency in Hz (default 100000)",    // tp_doc
+   0,                         // tp_traverse
+   0,                         // tp_clear
+   0,                         // tp_richcompare
+   0,                         // tp_weaklistoffset
+   0,                         // tp_iter
+   0,                         // tp_iternext
+   SoftI2C_methods,           // tp_methods
+   0,                         // tp_members
+   0,                         // tp_getset
+   0,                         // tp_base
+   0,                         // tp_dict
+   0,                         // tp_descr_get
+   0,                         // tp_descr_set
+   0,                         // tp_dictoffset
+   (initproc)SoftI2C_init,    // tp_init
+   0,                         // tp_alloc
+   0,                         // tp_new
+};
+
+PyTypeObject *SoftI2C_init_SoftI2CType(void)
+{
+   // Fill in some slots in the type, and make it ready
+   SoftI2CType.tp_new = PyType_GenericNew;
+   if (PyType_Ready(&SoftI2CType) < 0)
+      return NULL;
+
+   return &SoftI2CType;
+}
@@ -0,0 +1,249 @@
+/*
+Copyright (c) 2020 GC2
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+of the Software, and to permit persons to whom the Software is furnished to do
+so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "Python.h"
+#include "soft_spi.h"
+#include "py_soft_spi.h"
+#include "common.h"
+#include "c_gpio.h"
+
+// transfers at least this long are run with the GIL released
+#define SPI_RELEASE_GIL_LEN 32
+
+typedef struct
+{
+    PyObject_HEAD
+    struct soft_spi spi;
+    int ready;
+} SoftSPIObject;
+
+// python method SoftSPI.__init__(self, sclk, mosi, miso, cs, mode=0, speed=1000000)
+static int SoftSPI_init(SoftSPIObject *self, PyObject *args, PyObject *kwds)
+{
+    int sclk_channel;
+    unsigned int sclk;
+    PyObject *mosi, *miso, *cs;
+    int mode = 0;
+    int speed = 1000000;
+    int pins[4];
+    int i, j;
+    static char *kwlist[] = {"sclk", "mosi", "miso", "cs", "mode", "speed", NULL};
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "iOOO|ii", kwlist, &sclk_channel, &mosi, &miso, &cs, &mode, &speed))
+        return -1;
+
+    if (get_gpio_number(sclk_channel, &sclk) ||
+        get_optional_gpio_number(mosi, &self->spi.mosi) ||
+        get_optional_gpio_number(miso, &self->spi.miso) ||
+        get_optional_gpio_number(cs, &self->spi.cs))
+        return -1;
+    self->spi.sclk = sclk;
+
+    pins[0] = sclk;
+    pins[1] = self->spi.mosi;
+    pins[2] = self->spi.miso;
+    pins[3] = self->spi.cs;
+    for (i=1; i<4; i++)
+        for (j=0; j<i; j++)
+            if (pins[i] >= 0 && pins[i] == pins[j])
+            {
+                PyErr_SetString(PyExc_ValueError, "sclk, mosi, miso and cs must be different channels");
+                return -1;
+            }
+
+    if (mode < 0 || mode > 3)
+    {
+        PyErr_SetString(PyExc_ValueError, "mode must be 0, 1, 2 or 3");
+        return -1;
+    }
+
+    if (speed <= 0)
+    {
+        PyErr_SetString(PyExc_ValueError, "speed must be greater than 0");
+        return -1;
+    }
+
+    if (mmap_gpio_mem())
+        return -1;
+
+    self->spi.mode = mode;
+    self->spi.half_period = 500000000UL / speed;
+    soft_spi_setup(&self->spi);
+
+    // so that cleanup() resets the pins
+    gpio_direction[sclk] = OUTPUT;
+    if (self->spi.mosi >= 0)
+        gpio_direction[self->spi.mosi] = OUTPUT;
+    if (self->spi.miso >= 0)
+        gpio_direction[self->spi.miso] = INPUT;
+    if (self->spi.cs >= 0)
+        gpio_direction[self->spi.cs] = OUTPUT;
+    self->ready = 1;
+    return 0;
+}
+
+static PyObject *do_transfer(SoftSPIObject *self, const unsigned char *tx, Py_ssize_t len, int read)
+{
+    PyObject *result = NULL;
+    unsigned char *rx = NULL;
+
+    if (!self->ready)
+    {
+        PyErr_SetString(PyExc_RuntimeError, "SoftSPI object not initialised");
+        return NULL;
+    }
+
+    if (check_gpio_priv())
+        return NULL;
+
+    if (read)
+    {
+        if ((result = PyBytes_FromStringAndSize(NULL, len)) == NULL)
+            return NULL;
+        rx = (unsigned char *)PyBytes_AS_STRING(result);
+    }
+
+    if (len >= SPI_RELEASE_GIL_LEN)
+    {
+        Py_BEGIN_ALLOW_THREADS // disable GIL
+        soft_spi_transfer(&self->spi, tx, rx, len);
+        Py_END_ALLOW_THREADS   // enable GIL
+    } else {
+        soft_spi_transfer(&self->spi, tx, rx, len);
+    }
+
+    if (read)
+        return result;
+    Py_RETURN_NONE;
+}
+
+// python method SoftSPI.transfer(self, data)
+static PyObject *SoftSPI_transfer(SoftSPIObject *self, PyObject *args)
+{
+    Py_buffer data;
+    PyObject *result;
+
+#if PY_MAJOR_VERSION > 2
+    if (!PyArg_ParseTuple(args, "y*", &data))
+#else
+    if (!PyArg_ParseTuple(args, "s*", &data))
+#endif
+        return NULL;
+
+    result = do_transfer(self, (const unsigned char *)data.buf, data.len, 1);
+    PyBuffer_Release(&data);
+    return result;
+}
+
+// python method SoftSPI.write(self, data)
+static PyObject *SoftSPI_write(SoftSPIObject *self, PyObject *args)
+{
+    Py_buffer data;
+    PyObject *result;
+
+#if PY_MAJOR_VERSION > 2
+    if (!PyArg_ParseTuple(args, "y*", &data))
+#else
+    if (!PyArg_ParseTuple(args, "s*", &data))
+#endif
+        return NULL;
+
+    result = do_transfer(self, (const unsigned char *)data.buf, data.len, 0);
+    PyBuffer_Release(&data);
+    return result;
+}
+
+// python method SoftSPI.read(self, length)
+static PyObject *SoftSPI_read(SoftSPIObject *self, PyObject *args)
+{
+    Py_ssize_t len;
+
+    if (!PyArg_ParseTuple(args, "n", &len))
+        return NULL;
+
+    if (len < 0)
+    {
+        PyErr_SetString(PyExc_ValueError, "length must not be negative");
+        return NULL;
+    }
+
+    return do_transfer(self, NULL, len, 1);
+}
+
+static PyMethodDef
+SoftSPI_methods[] = {
+   { "transfer", (PyCFunction)SoftSPI_transfer, METH_VARARGS, "Send bytes and return the bytes received at the same time\ndata - bytes to send" },
+   { "write", (PyCFunction)SoftSPI_write, METH_VARARGS, "Send bytes, ignoring MISO\ndata - bytes to send" },
+   { "read", (PyCFunction)SoftSPI_read, METH_VARARGS, "Receive bytes while sending zeroes\nlength - number of bytes" },
+   { NULL }
+};
+
+PyTypeObject SoftSPIType = {
+   PyVarObject_HEAD_INIT(NULL,0)
+   "RPi.GPIO.SoftSPI",        // tp_name
+   sizeof(SoftSPIObject),     // tp_basicsize
+   0,                         // tp_itemsize
+   0,                         // tp_dealloc
+   0,                         // tp_print
+   0,                         // tp_getattr
+   0,                         // tp_setattr
+   0,                         // tp_compare
+   0,                         // tp_repr
+   0,                         // tp_as_number
+   0,                         // tp_as_sequence
+   0,                         // tp_as_mapping
+   0,                         // tp_hash
+   0,                         // tp_call
+   0,                         // tp_str
+   0,                         // tp_getattro
+   0,                         // tp_setattro
+   0,                         // tp_as_buffer
+   Py_TPFLAGS_DEFAULT | Py_TPFLAGS_BASETYPE, // tp_flag
+   "Bit-banged SPI master class\nsclk, mosi, miso, cs - channels (mosi, miso and cs may be None)\n[mode]  - SPI mode 0..3 (default 0)\n[speed] - clock frequency in Hz (default 1000000)",    // tp_doc
+   0,                         // tp_traverse
+   0,                         // tp_clear
+   0,                         // tp_richcompare
+   0,                         // tp_weaklistoffset
+   0,                         // tp_iter
+   0,                         // tp_iternext
+   SoftSPI_methods,           // tp_methods
+   0,                         // tp_members
+   0,                         // tp_getset
+   0,                         // tp_base
+   0,                         // tp_dict
+   0,                         // tp_descr_get
+   0,                         // tp_descr_set
+   0,                         // tp_dictoffset
+   (initproc)SoftSPI_init,    // tp_init
+   0,                         // tp_alloc
+   0,                         // tp_new
+};
+
+PyTypeObject *SoftSPI_init_SoftSPIType(void)
+{
+   // Fill in some slots in the type, and make it ready
+   SoftSPIType.tp_new = PyType_GenericNew;
+   if (PyType_Ready(&SoftSPIType) < 0)
+      return NULL;
+
+   return &SoftSPIType;
+}
@@ -0,0 +1,408 @@
+/*
+Copyright (c) 2020 GC2
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+of the Software, and to permit persons to whom the Software is furnished to do
+so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "Python.h"
+#include "stepper.h"
+#include "py_stepper.h"
+#include "common.h"
+#include "c_gpio.h"
+
+// most axes in one move_together()
+#define MAX_AXES 16
+
+typedef struct
+{
+    PyObject_HEAD
+    struct stepper *stepper;
+} StepperObject;
+
+static int check_speed(double speed, double accel)
+{
+    if (speed <= 0.0 || speed > 500000.0)
+    {
+        PyErr_SetString(PyExc_ValueError, "speed must be greater than 0 and at most 500000 steps/s");
+        return 1;
+    }
+    if (accel < 0.0)
+    {
+        PyErr_SetString(PyExc_ValueError, "accel must not be negative");
+        return 1;
+    }
+    return 0;
+}
+
+// 1 if a Stepper other than self drives gpio
+static int in_use(StepperObject *self, unsigned int gpio)
+{
+    struct stepper *s = stepper_find(gpio);
+
+    return s != NULL && s != self->stepper;
+}
+
+// python method Stepper.__init__(self, step, dir, enable=None, speed=1000.0, accel=1000.0)
+static int Stepper_init(StepperObject *self, PyObject *args, PyObject *kwds)
+{
+    int step_channel, dir_channel;
+    unsigned int step, dir;
+    int enable;
+    PyObject *enable_channel = Py_None;
+    double speed = 1000.0;
+    double accel = 1000.0;
+    static char *kwlist[] = {"step", "dir", "enable", "speed", "accel", NULL};
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "ii|Odd", kwlist, &step_channel, &dir_channel, &enable_channel, &speed, &accel))
+        return -1;
+
+    if (get_gpio_number(step_channel, &step) ||
+        get_gpio_number(dir_channel, &dir) ||
+        get_optional_gpio_number(enable_channel, &enable))
+        return -1;
+
+    if (step == dir || (int)step == enable || (int)dir == enable)
+    {
+        PyErr_SetString(PyExc_ValueError, "step, dir and enable must be different channels");
+        return -1;
+    }
+
+    if (check_speed(speed, accel))
+        return -1;
+
+    if (in_use(self, step) || in_use(self, dir) || (enable >= 0 && in_use(self, enable)))
+    {
+        PyErr_SetString(PyExc_RuntimeError, "Another Stepper object already uses this GPIO channel");
+        return -1;
+    }
+
+    if (mmap_gpio_mem())
+        return -1;
+
+    if (self->stepper != NULL)
+    {
+        stepper_free(self->stepper);
+        self->stepper = NULL;
+    }
+
+    output_gpio(step, 0);
+    setup_gpio(step, OUTPUT, PUD_OFF);
+    gpio_direction[step] = OUTPUT;
+    output_gpio(dir, 0);
+    setup_gpio(dir, OUTPUT, PUD_OFF);
+    gpio_direction[dir] = OUTPUT;
+    if (enable >= 0)
+    {
+        // active low - the driver is enabled straight away
+        output_gpio(enable, 0);
+        setup_gpio(enable, OUTPUT, PUD_OFF);
+        gpio_direction[enable] = OUTPUT;
+    }
+
+    if ((self->stepper = stepper_new(step, dir, enable)) == NULL)
+    {
+        PyErr_SetString(PyExc_RuntimeError, "Failed to start the stepper thread");
+        return -1;
+    }
+    stepper_set_speed(self->stepper, speed, accel);
+    return 0;
+}
+
+static int check_stepper(StepperObject *self)
+{
+    if (self->stepper == NULL)
+    {
+        PyErr_SetString(PyExc_RuntimeError, "Stepper object not initialised");
+        return 1;
+    }
+    return check_gpio_priv();
+}
+
+static PyObject *do_move(struct stepper **steppers, const long *targets, int count)
+{
+    if (stepper_move(steppers, targets, count))
+        return PyErr_NoMemory();
+    Py_RETURN_NONE;
+}
+
+// python method Stepper.move(self, steps)
+static PyObject *Stepper_move(StepperObject *self, PyObject *args)
+{
+    long steps, target;
+
+    if (!PyArg_ParseTuple(args, "l", &steps))
+        return NULL;
+
+    if (check_stepper(self))
+        return NULL;
+
+    target = stepper_position(self->stepper) + steps;
+    return do_move(&self->stepper, &target, 1);
+}
+
+// python method Stepper.move_to(self, position)
+static PyObject *Stepper_move_to(StepperObject *self, PyObject *args)
+{
+    long target;
+
+    if (!PyArg_ParseTuple(args, "l", &target))
+        return NULL;
+
+    if (check_stepper(self))
+        return NULL;
+
+    return do_move(&self->stepper, &target, 1);
+}
+
+// python method Stepper.move_together(moves)
+static PyObject *Stepper_move_together(PyObject *cls, PyObject *args)
+{
+    PyObject *moves, *seq, *item;
+    StepperObject *obj;
+    struct stepper *steppers[MAX_AXES];
+    long targets[MAX_AXES];
+    int count, i, j;
+
+    if (!PyArg_ParseTuple(args, "O", &moves))
+        return NULL;
+
+    if ((seq = PySequence_Fast(moves, "moves must be a list/tuple of (Stepper, position) pairs")) == NULL)
+        return NULL;
+
+    count = PySequence_Fast_GET_SIZE(seq);
+    if (count < 1 || count > MAX_AXES)
+    {
+        Py_DECREF(seq);
+        PyErr_Format(PyExc_ValueError, "Between 1 and %d axes can be moved together", MAX_AXES);
+        return NULL;
+    }
+
+    for (i=0; i<count; i++)
+    {
+        item = PySequence_Fast_GET_ITEM(seq, i);
+        if (!PyTuple_Check(item))
+        {
+            Py_DECREF(seq);
+            PyErr_SetString(PyExc_ValueError, "moves must be a list/tuple of (Stepper, position) pairs");
+            return NULL;
+        }
+        if (!PyArg_ParseTuple(item, "O!l", &StepperType, &obj, &targets[i]) || check_stepper(obj))
+        {
+            Py_DECREF(seq);
+            return NULL;
+        }
+        steppers[i] = obj->stepper;
+        for (j=0; j<i; j++)
+            if (steppers[j] == steppers[i])
+            {
+                Py_DECREF(seq);
+                PyErr_SetString(PyExc_ValueError, "A Stepper appears more than once");
+                return NULL;
+            }
+    }
+    Py_DECREF(seq);
+
+    return do_move(steppers, targets, count);
+}
+
+// python method Stepper.wait(self, timeout=None)
+static PyObject *Stepper_wait(StepperObject *self, PyObject *args, PyObject *kwds)
+{
+    PyObject *timeout = Py_None;
+    int timeout_ms = -1;
+    int idle;
+    double seconds;
+    static char *kwlist[] = {"timeout", NULL};
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "|O", kwlist, &timeout))
+        return NULL;
+
+    if (check_stepper(self))
+        return NULL;
+
+    if (timeout != Py_None)
+    {
+        seconds = PyFloat_AsDouble(timeout);
+        if (PyErr_Occurred())
+            return NULL;
+        if (seconds < 0.0)
+        {
+            PyErr_SetString(PyExc_ValueError, "timeout must not be negative");
+            return NULL;
+        }
+        timeout_ms = (int)(seconds * 1000.0);
+    }
+
+    Py_BEGIN_ALLOW_THREADS // disable GIL
+    idle = stepper_wait(self->stepper, timeout_ms);
+    Py_END_ALLOW_THREADS   // enable GIL
+
+    return PyBool_FromLong(idle);
+}
+
+// python method Stepper.stop(self)
+static PyObject *Stepper_stop(StepperObject *self, PyObject *args)
+{
+    if (check_stepper(self))
+        return NULL;
+
+    stepper_stop(self->stepper);
+    Py_RETURN_NONE;
+}
+
+// python method Stepper.position(self)
+static PyObject *Stepper_position(StepperObject *self, PyObject *args)
+{
+    if (check_stepper(self))
+        return NULL;
+
+    return Py_BuildValue("l", stepper_position(self->stepper));
+}
+
+// python method Stepper.set_position(self, position)
+static PyObject *Stepper_set_position(StepperObject *self, PyObject *args)
+{
+    long position;
+
+    if (!PyArg_ParseTuple(args, "l", &position))
+        return NULL;
+
+    if (check_stepper(self))
+        return NULL;
+
+    if (stepper_set_position(self->stepper, position))
+    {
+        PyErr_SetString(PyExc_RuntimeError, "The position cannot be set while the motor is moving");
+        return NULL;
+    }
+    Py_RETURN_NONE;
+}
+
+// python method Stepper.is_moving(self)
+static PyObject *Stepper_is_moving(StepperObject *self, PyObject *args)
+{
+    if (check_stepper(self))
+        return NULL;
+
+    return PyBool_FromLong(stepper_moving(self->stepper));
+}
+
+// python method Stepper.set_speed(self, speed, accel)
+static PyObject *Stepper_set_speed(StepperObject *self, PyObject *args)
+{
+    double speed, accel;
+
+    if (!PyArg_ParseTuple(args, "dd", &speed, &accel))
+        return NULL;
+
+    if (check_stepper(self) || check_speed(speed, accel))
+        return NULL;
+
+    stepper_set_speed(self->stepper, speed, accel);
+    Py_RETURN_NONE;
+}
+
+// python method Stepper.enable(self, state)
+static PyObject *Stepper_enable(StepperObject *self, PyObject *args)
+{
+    int state;
+
+    if (!PyArg_ParseTuple(args, "i", &state))
+        return NULL;
+
+    if (check_stepper(self))
+        return NULL;
+
+    stepper_enable(self->stepper, state);
+    Py_RETURN_NONE;
+}
+
+// deallocation method
+static void Stepper_dealloc(StepperObject *self)
+{
+    if (self->stepper != NULL)
+        stepper_free(self->stepper);
+    Py_TYPE(self)->tp_free((PyObject*)self);
+}
+
+static PyMethodDef
+Stepper_methods[] = {
+   { "move", (PyCFunction)Stepper_move, METH_VARARGS, "Start a move relative to the current position\nsteps - number of steps (negative to reverse)" },
+   { "move_to", (PyCFunction)Stepper_move_to, METH_VARARGS, "Start a move to an absolute position\nposition - target position in steps" },
+   { "move_together", (PyCFunction)Stepper_move_together, METH_VARARGS | METH_STATIC, "Start coordinated moves that begin and end together\nmoves - list/tuple of (Stepper, position) pairs.  The longest move uses its own speed and accel" },
+   { "wait", (PyCFunction)Stepper_wait, METH_VARARGS | METH_KEYWORDS, "Wait for the current move to finish.  Returns False on timeout\n[timeout] - seconds to wait (default None waits forever)" },
+   { "stop", (PyCFunction)Stepper_stop, METH_NOARGS, "Stop immediately" },
+   { "position", (PyCFunction)Stepper_position, METH_NOARGS, "Return the position in steps" },
+   { "set_position", (PyCFunction)Stepper_set_position, METH_VARARGS, "Set the current position while stopped\nposition - new position in steps" },
+   { "is_moving", (PyCFunction)Stepper_is_moving, METH_NOARGS, "Return whether a move is in progress" },
+   { "set_speed", (PyCFunction)Stepper_set_speed, METH_VARARGS, "Set the speed profile used by the following moves\nspeed - top speed in steps/s\naccel - acceleration in steps/s^2 (0 for none)" },
+   { "enable", (PyCFunction)Stepper_enable, METH_VARARGS, "Enable or disable the driver using the enable channel\nstate - True or False" },
+   { NULL }
+};
+
+PyTypeObject StepperType = {
+   PyVarObject_HEAD_INIT(NULL,0)
+   "RPi.GPIO.Stepper",        // tp_name
+   sizeof(StepperObject),     // tp_basicsize
+   0,                         // tp_itemsize
+   (destructor)Stepper_dealloc, // tp_dealloc
+   0,                         // tp_print
+   0,                         // tp_getattr
+   0,                         // tp_setattr
+   0,                         // tp_compare
+   0,                         // tp_repr
+   0,                         // tp_as_number
+   0,                         // tp_as_sequence
+   0,                         // tp_as_mapping
+   0,                         // tp_hash
+   0,                         // tp_call
+   0,                         // tp_str
+   0,                         // tp_getattro
+   0,                         // tp_setattro
+   0,                         // tp_as_buffer
+   Py_TPFLAGS_DEFAULT | Py_TPFLAGS_BASETYPE, // tp_flag
+   "Stepper motor (STEP/DIR driver) class\nstep, dir - channels\n[enable]  - active low enable channel (default None)\n[speed]   - top speed in steps/s (default 1000)\n[accel]   - acceleration in steps/s^2, 0 for none (default 1000)",    // tp_doc
+   0,                         // tp_traverse
+   0,                         // tp_clear
+   0,                         // tp_richcompare
+   0,                         // tp_weaklistoffset
+   0,                         // tp_iter
+   0,                         // tp_iternext
+   Stepper_methods,           // tp_methods
+   0,                         // tp_members
+   0,                         // tp_getset
+   0,                         // tp_base
+   0,                         // tp_dict
+   0,                         // tp_descr_get
+   0,                         // tp_descr_set
+   0,                         // tp_dictoffset
+   (initproc)Stepper_init,    // tp_init
+   0,                         // tp_alloc
+   0,                         // tp_new
+};
+
+PyTypeObject *Stepper_init_StepperType(void)
+{
+   // Fill in some slots in the type, and make it ready
+   StepperType.tp_new = PyType_GenericNew;
+   if (PyType_Ready(&StepperType) < 0)
+      return NULL;
+
+   return &StepperType;
+}
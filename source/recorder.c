@@ -0,0 +1,135 @@
+/*
+Copyright (c) 2020 GC2
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+of the Software, and to permit persons to whom the Software is furnished to do
+so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include "c_gpio.h"
+#include "event_gpio.h"
+#include "recorder.h"
+
+#define MAX_RECORDED 64
+
+static struct recorder_header *header = NULL;
+static struct recorder_record *records;
+static size_t map_size;
+static unsigned int recorded[MAX_RECORDED];
+static int num_recorded = 0;
+
+// called from the event thread - only touches the mapping, never blocks
+static void record_edge(unsigned int gpio, int level, unsigned long long timestamp, void *data)
+{
+    uint64_t n = header->count;
+    struct recorder_record *r = &records[n % header->capacity];
+
+    r->timestamp = timestamp;
+    r->gpio = gpio;
+    r->level = level;
+    __atomic_store_n(&header->count, n + 1, __ATOMIC_RELEASE);
+}
+
+// return values:
+// 0 - Success
+// 1 - Already recording
+// 2 - Could not create or map the file (errno is set)
+// 3 - capacity too large for the address space
+int recorder_start(const char *path, unsigned long capacity)
+{
+    struct timespec real, mono;
+    int fd;
+    void *map;
+
+    if (header != NULL)
+        return 1;
+
+    if (capacity > (SIZE_MAX - sizeof(struct recorder_header)) / sizeof(struct recorder_record))
+        return 3;
+    map_size = sizeof(struct recorder_header) + capacity * sizeof(struct recorder_record);
+    if ((fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644)) < 0)
+        return 2;
+    if (ftruncate(fd, map_size) < 0) {
+        close(fd);
+        return 2;
+    }
+    map = mmap(NULL, map_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED)
+        return 2;
+
+    header = (struct recorder_header *)map;
+    records = (struct recorder_record *)(header + 1);
+    memcpy(header->magic, RECORDER_MAGIC, sizeof(header->magic));
+    header->version = RECORDER_VERSION;
+    header->record_size = sizeof(struct recorder_record);
+    header->capacity = capacity;
+    header->count = 0;
+    header->closed = 0;
+    clock_gettime(CLOCK_REALTIME, &real);
+    clock_gettime(CLOCK_MONOTONIC, &mono);
+    header->realtime_offset = (real.tv_sec - mono.tv_sec) * 1000000000LL + (real.tv_nsec - mono.tv_nsec);
+    num_recorded = 0;
+    return 0;
+}
+
+// return values:
+// 0 - Success
+// 1 - Conflicting edge detection already added
+// 2 - Other error
+int recorder_add(unsigned int gpio)
+{
+    int i, result;
+
+    if (header == NULL)
+        return 2;
+    for (i=0; i<num_recorded; i++)
+        if (recorded[i] == gpio)
+            return 0;
+    if (num_recorded == MAX_RECORDED)
+        return 2;
+    if ((result = add_edge_monitor(gpio, record_edge, NULL)) != 0)
+        return result;
+    recorded[num_recorded++] = gpio;
+    return 0;
+}
+
+void recorder_stop(void)
+{
+    int i;
+
+    if (header == NULL)
+        return;
+    for (i=0; i<num_recorded; i++)
+        remove_edge_monitor(recorded[i], record_edge, NULL);
+    num_recorded = 0;
+    __atomic_store_n(&header->closed, 1, __ATOMIC_RELEASE);
+    msync(header, map_size, MS_SYNC);
+    munmap(header, map_size);
+    header = NULL;
+}
+
+int recorder_active(void)
+{
+    return header != NULL;
+}
@@ -0,0 +1,54 @@
+/*
+Copyright (c) 2020 GC2
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+of the Software, and to permit persons to whom the Software is furnished to do
+so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/* Edge recording into a memory mapped ring buffer file */
+
+#include <stdint.h>
+
+#define RECORDER_MAGIC "GPIOLOG1"
+#define RECORDER_VERSION 1
+
+// the file is a 64 byte header followed by capacity records
+// record n (counting from 0 since the start) is at index n % capacity
+struct recorder_header
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t record_size;
+    uint64_t capacity;
+    uint64_t count;             // records written so far, updated after each record
+    int64_t realtime_offset;    // ns to add to a timestamp for CLOCK_REALTIME
+    uint8_t closed;             // set by recorder_stop() after the last record
+    uint8_t reserved[23];
+};
+
+struct recorder_record
+{
+    uint64_t timestamp;         // ns, CLOCK_MONOTONIC
+    uint32_t gpio;
+    uint32_t level;
+};
+
+int recorder_start(const char *path, unsigned long capacity);
+int recorder_add(unsigned int gpio);
+void recorder_stop(void);
+int recorder_active(void);
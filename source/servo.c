@@ -0,0 +1,246 @@
+/*
+Copyright (c) 2020 GC2
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+of the Software, and to permit persons to whom the Software is furnished to do
+so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+#include "c_gpio.h"
+#include "servo.h"
+
+#define FRAME_NS 20000000ULL
+#define MAX_STAGGER_NS 1000000ULL
+#define SPIN_NS 100000ULL     // busy wait the last part of every sleep
+#define MERGE_NS 1000ULL      // edges this close together share one store
+#define MAX_SERVOS 64
+
+struct servo
+{
+    unsigned int gpio;
+    unsigned int width;     // us, 0 for no pulses
+    struct servo *next;
+};
+static struct servo *servo_list = NULL;
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static int thread_running = 0;
+
+struct edge
+{
+    unsigned long long time;    // ns from the start of the frame
+    uint64_t set;
+    uint64_t clr;
+};
+
+static void wait_until(unsigned long long deadline)
+{
+    struct timespec ts;
+    unsigned long long now = monotonic_ns();
+
+    if (deadline > now + SPIN_NS) {
+        ts.tv_sec = (deadline - SPIN_NS) / 1000000000ULL;
+        ts.tv_nsec = (deadline - SPIN_NS) % 1000000000ULL;
+        while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) != 0)
+            ;
+    }
+    while (monotonic_ns() < deadline)
+        ;
+}
+
+// build the edges of one frame - pulse starts are spread out over the frame
+// so that the servos don't all draw their peak current at the same moment
+// returns the number of edges
+static int build_frame(struct edge *edges)
+{
+    struct servo *s;
+    unsigned long long stagger, start;
+    int n = 0;
+    int count = 0;
+    int i, j;
+    struct edge e;
+
+    for (s = servo_list; s != NULL; s = s->next)
+        if (s->width)
+            n++;
+    if (n == 0)
+        return 0;
+    stagger = (FRAME_NS - SERVO_MAX_WIDTH * 1000ULL) / n;
+    if (stagger > MAX_STAGGER_NS)
+        stagger = MAX_STAGGER_NS;
+
+    for (s = servo_list; s != NULL && count < MAX_SERVOS*2; s = s->next) {
+        if (!s->width)
+            continue;
+        start = (count / 2) * stagger;
+        edges[count].time = start;
+        edges[count].set = 1ULL << s->gpio;
+        edges[count++].clr = 0;
+        edges[count].time = start + s->width * 1000ULL;
+        edges[count].set = 0;
+        edges[count++].clr = 1ULL << s->gpio;
+    }
+
+    // insertion sort by time, then merge edges that nearly coincide
+    for (i=1; i<count; i++) {
+        e = edges[i];
+        for (j=i; j>0 && edges[j-1].time > e.time; j--)
+            edges[j] = edges[j-1];
+        edges[j] = e;
+    }
+    for (i=0, j=1; j<count; j++) {
+        if (edges[j].time - edges[i].time <= MERGE_NS) {
+            edges[i].set |= edges[j].set;
+            edges[i].clr |= edges[j].clr;
+        } else {
+            edges[++i] = edges[j];
+        }
+    }
+    return i + 1;
+}
+
+static void *servo_thread(void *threadarg)
+{
+    struct sched_param param;
+    struct edge edges[MAX_SERVOS*2];
+    unsigned long long frame = monotonic_ns();
+    int count, i;
+
+    // best effort - carry on at normal priority if not permitted
+    param.sched_priority = sched_get_priority_max(SCHED_FIFO);
+    pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+
+    while (1) {
+        pthread_mutex_lock(&lock);
+        if (servo_list == NULL) {
+            thread_running = 0;
+            pthread_mutex_unlock(&lock);
+            break;
+        }
+        count = build_frame(edges);
+        pthread_mutex_unlock(&lock);
+
+        for (i=0; i<count; i++) {
+            wait_until(frame + edges[i].time);
+            output_gpio_mask(edges[i].set, edges[i].clr);
+        }
+
+        frame += FRAME_NS;
+        if (frame < monotonic_ns())   // overran - start afresh rather than bunching frames
+            frame = monotonic_ns();
+        wait_until(frame);
+    }
+    pthread_exit(NULL);
+}
+
+// return values:
+// 0 - success
+// 1 - a servo already exists on this gpio
+// 2 - out of memory or the thread could not be started
+int servo_start(unsigned int gpio, unsigned int width_us)
+{
+    struct servo *s;
+    pthread_t thread;
+    int count = 0;
+
+    pthread_mutex_lock(&lock);
+    for (s = servo_list; s != NULL; s = s->next) {
+        if (s->gpio == gpio) {
+            pthread_mutex_unlock(&lock);
+            return 1;
+        }
+        count++;
+    }
+
+    if (count >= MAX_SERVOS || (s = malloc(sizeof(struct servo))) == NULL) {
+        pthread_mutex_unlock(&lock);
+        return 2;
+    }
+    s->gpio = gpio;
+    s->width = width_us;
+    s->next = servo_list;
+    servo_list = s;
+
+    if (!thread_running) {
+        if (pthread_create(&thread, NULL, servo_thread, NULL) != 0) {
+            servo_list = s->next;
+            free(s);
+            pthread_mutex_unlock(&lock);
+            return 2;
+        }
+        pthread_detach(thread);
+        thread_running = 1;
+    }
+    pthread_mutex_unlock(&lock);
+    return 0;
+}
+
+// takes effect from the next frame
+void servo_set_width(unsigned int gpio, unsigned int width_us)
+{
+    struct servo *s;
+
+    pthread_mutex_lock(&lock);
+    for (s = servo_list; s != NULL; s = s->next)
+        if (s->gpio == gpio)
+            s->width = width_us;
+    pthread_mutex_unlock(&lock);
+}
+
+void servo_stop(unsigned int gpio)
+{
+    struct servo **p, *s;
+
+    pthread_mutex_lock(&lock);
+    for (p = &servo_list; *p != NULL; p = &(*p)->next)
+        if ((*p)->gpio == gpio) {
+            s = *p;
+            *p = s->next;
+            free(s);
+            break;
+        }
+    pthread_mutex_unlock(&lock);
+}
+
+void servo_stop_all(void)
+{
+    struct servo *s;
+
+    pthread_mutex_lock(&lock);
+    while ((s = servo_list) != NULL) {
+        servo_list = s->next;
+        free(s);
+    }
+    pthread_mutex_unlock(&lock);
+}
+
+int servo_exists(unsigned int gpio)
+{
+    struct servo *s;
+    int found = 0;
+
+    pthread_mutex_lock(&lock);
+    for (s = servo_list; s != NULL; s = s->next)
+        if (s->gpio == gpio)
+            found = 1;
+    pthread_mutex_unlock(&lock);
+    return found;
+}
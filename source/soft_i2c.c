@@ -0,0 +1,188 @@
+/*
+Copyright (c) 2020 GC2
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+of the Software, and to permit persons to whom the Software is furnished to do
+so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "c_gpio.h"
+#include "soft_i2c.h"
+
+// how long a slave may hold SCL low (clock stretching)
+#define STRETCH_TIMEOUT_NS 25000000ULL
+
+// open drain emulation - the output latch is held at 0 and the pin is
+// switched between output (drive low) and input (released, pulled high)
+static void drive_low(unsigned int gpio)
+{
+    set_direction_gpio(gpio, OUTPUT);
+}
+
+static void release(unsigned int gpio)
+{
+    set_direction_gpio(gpio, INPUT);
+}
+
+static void half_delay(struct soft_i2c *i2c)
+{
+    if (i2c->half_period)
+        delay_ns(i2c->half_period);
+}
+
+// release SCL and wait for any slave stretching the clock
+// return values:
+// 0 - success
+// 2 - timeout
+static int release_scl(struct soft_i2c *i2c)
+{
+    unsigned long long deadline;
+
+    release(i2c->scl);
+    if (input_gpio(i2c->scl))
+        return 0;
+    deadline = monotonic_ns() + STRETCH_TIMEOUT_NS;
+    while (!input_gpio(i2c->scl))
+        if (monotonic_ns() > deadline)
+            return 2;
+    return 0;
+}
+
+static int start_condition(struct soft_i2c *i2c)
+{
+    // also serves as a repeated start when SCL is low
+    release(i2c->sda);
+    half_delay(i2c);
+    if (release_scl(i2c))
+        return 2;
+    half_delay(i2c);
+    drive_low(i2c->sda);
+    half_delay(i2c);
+    drive_low(i2c->scl);
+    return 0;
+}
+
+static int stop_condition(struct soft_i2c *i2c)
+{
+    drive_low(i2c->sda);
+    half_delay(i2c);
+    if (release_scl(i2c))
+        return 2;
+    half_delay(i2c);
+    release(i2c->sda);
+    half_delay(i2c);
+    return 0;
+}
+
+static int clock_bit(struct soft_i2c *i2c, int bit)
+// returns the level of SDA sampled while SCL is high, or -1 on timeout
+{
+    int level;
+
+    if (bit)
+        release(i2c->sda);
+    else
+        drive_low(i2c->sda);
+    half_delay(i2c);
+    if (release_scl(i2c))
+        return -1;
+    half_delay(i2c);
+    level = !!input_gpio(i2c->sda);
+    drive_low(i2c->scl);
+    return level;
+}
+
+// return values:
+// 0 - ACK
+// 1 - NACK
+// 2 - timeout
+static int write_byte(struct soft_i2c *i2c, unsigned char byte)
+{
+    int bit, ack;
+
+    for (bit=7; bit>=0; bit--)
+        if (clock_bit(i2c, (byte >> bit) & 1) < 0)
+            return 2;
+    if ((ack = clock_bit(i2c, 1)) < 0)
+        return 2;
+    return ack ? 1 : 0;
+}
+
+static int read_byte(struct soft_i2c *i2c, unsigned char *byte, int ack)
+{
+    int bit, level;
+
+    *byte = 0;
+    for (bit=7; bit>=0; bit--) {
+        if ((level = clock_bit(i2c, 1)) < 0)
+            return 2;
+        *byte |= level << bit;
+    }
+    if (clock_bit(i2c, !ack) < 0)
+        return 2;
+    return 0;
+}
+
+void soft_i2c_setup(struct soft_i2c *i2c)
+{
+    output_gpio(i2c->sda, 0);
+    output_gpio(i2c->scl, 0);
+    setup_gpio(i2c->sda, INPUT, PUD_UP);
+    setup_gpio(i2c->scl, INPUT, PUD_UP);
+}
+
+// writes wbuf then reads rbuf (with a repeated start) from 7 bit address addr
+// either part may be empty
+// return values:
+// 0 - success
+// 1 - NACK
+// 2 - timeout waiting for SCL
+int soft_i2c_transfer(struct soft_i2c *i2c, unsigned int addr, const unsigned char *wbuf, size_t wlen, unsigned char *rbuf, size_t rlen)
+{
+    int result = 0;
+    size_t i;
+
+    if (wlen || !rlen) {
+        if ((result = start_condition(i2c)) != 0)
+            goto done;
+        if ((result = write_byte(i2c, addr << 1)) != 0)
+            goto done;
+        for (i=0; i<wlen; i++)
+            if ((result = write_byte(i2c, wbuf[i])) != 0)
+                goto done;
+    }
+
+    if (rlen) {
+        if ((result = start_condition(i2c)) != 0)
+            goto done;
+        if ((result = write_byte(i2c, (addr << 1) | 1)) != 0)
+            goto done;
+        for (i=0; i<rlen; i++)
+            if ((result = read_byte(i2c, &rbuf[i], i < rlen-1)) != 0)
+                goto done;
+    }
+
+done:
+    if (result == 2) {
+        // bus is stuck - let go of both lines
+        release(i2c->sda);
+        release(i2c->scl);
+    } else if (stop_condition(i2c)) {
+        result = 2;
+    }
+    return result;
+}
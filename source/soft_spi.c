@@ -0,0 +1,97 @@
+/*
+Copyright (c) 2020 GC2
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+of the Software, and to permit persons to whom the Software is furnished to do
+so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <stdint.h>
+#include "c_gpio.h"
+#include "soft_spi.h"
+
+#define GPIO_MASK(gpio) ((gpio) < 0 ? 0ULL : 1ULL << (gpio))
+
+void soft_spi_setup(struct soft_spi *spi)
+{
+    // clock idles at CPOL, chip select idles high
+    output_gpio(spi->sclk, spi->mode >> 1);
+    setup_gpio(spi->sclk, OUTPUT, PUD_OFF);
+    if (spi->mosi >= 0) {
+        output_gpio(spi->mosi, 0);
+        setup_gpio(spi->mosi, OUTPUT, PUD_OFF);
+    }
+    if (spi->miso >= 0)
+        setup_gpio(spi->miso, INPUT, PUD_OFF);
+    if (spi->cs >= 0) {
+        output_gpio(spi->cs, 1);
+        setup_gpio(spi->cs, OUTPUT, PUD_OFF);
+    }
+}
+
+void soft_spi_transfer(struct soft_spi *spi, const unsigned char *tx, unsigned char *rx, size_t len)
+// tx or rx may be NULL - zeroes are sent when tx is NULL
+{
+    uint64_t sclk_mask = GPIO_MASK(spi->sclk);
+    uint64_t mosi_mask = GPIO_MASK(spi->mosi);
+    uint64_t miso_mask = GPIO_MASK(spi->miso);
+    uint64_t cs_mask = GPIO_MASK(spi->cs);
+    uint64_t lead_set, lead_clr, mosi_set, mosi_clr;
+    unsigned long half = spi->half_period;
+    int cpha = spi->mode & 1;
+    unsigned char out, in, bit;
+    size_t i;
+
+    // the leading clock edge leaves the idle level CPOL
+    lead_set = (spi->mode & 2) ? 0 : sclk_mask;
+    lead_clr = (spi->mode & 2) ? sclk_mask : 0;
+
+    output_gpio_mask(0, cs_mask);
+    for (i=0; i<len; i++) {
+        out = tx ? tx[i] : 0;
+        in = 0;
+        for (bit=0x80; bit; bit>>=1) {
+            mosi_set = (out & bit) ? mosi_mask : 0;
+            mosi_clr = (out & bit) ? 0 : mosi_mask;
+            if (cpha == 0) {
+                // data is set up before the leading edge and sampled on it
+                output_gpio_mask(mosi_set, mosi_clr);
+                if (half)
+                    delay_ns(half);
+                output_gpio_mask(lead_set, lead_clr);
+                if (input_gpio_mask(miso_mask))
+                    in |= bit;
+                if (half)
+                    delay_ns(half);
+                output_gpio_mask(lead_clr, lead_set);
+            } else {
+                // data changes on the leading edge and is sampled on the trailing edge
+                output_gpio_mask(lead_set | mosi_set, lead_clr | mosi_clr);
+                if (half)
+                    delay_ns(half);
+                output_gpio_mask(lead_clr, lead_set);
+                if (input_gpio_mask(miso_mask))
+                    in |= bit;
+                if (half)
+                    delay_ns(half);
+            }
+        }
+        if (rx)
+            rx[i] = in;
+    }
+    output_gpio_mask(cs_mask, 0);
+}
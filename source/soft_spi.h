@@ -0,0 +1,38 @@
+/*
+Copyright (c) 2020 GC2
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+of the Software, and to permit persons to whom the Software is furnished to do
+so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/* Bit-banged SPI master */
+
+#include <stddef.h>
+
+struct soft_spi
+{
+    unsigned int sclk;
+    int mosi;                   // -1 if not used
+    int miso;                   // -1 if not used
+    int cs;                     // -1 if not used, active low
+    int mode;                   // SPI mode 0..3 (CPOL << 1 | CPHA)
+    unsigned long half_period;  // ns
+};
+
+void soft_spi_setup(struct soft_spi *spi);
+void soft_spi_transfer(struct soft_spi *spi, const unsigned char *tx, unsigned char *rx, size_t len);
@@ -0,0 +1,428 @@
+/*
+Copyright (c) 2020 GC2
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+of the Software, and to permit persons to whom the Software is furnished to do
+so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <math.h>
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+#include "c_gpio.h"
+#include "stepper.h"
+
+#define STEP_PULSE_NS 2000      // STEP high time, enough for A4988/DRV8825/TMC drivers
+#define DIR_SETUP_NS 1000       // DIR must be stable this long before a STEP edge
+#define SLEEP_SLACK_NS 1000000  // sleep on the condition variable until this close to a deadline
+#define MAX_RAMP 65536          // longest acceleration table in steps
+
+struct stepper
+{
+    unsigned int step;
+    unsigned int dir;
+    int enable;                 // -1 if not used, active low
+    double speed;               // steps/s
+    double accel;               // steps/s^2, 0 for no ramp
+    long position;              // atomic
+    // current move, protected by lock
+    int moving;
+    int direction;              // +1 or -1
+    unsigned long total;
+    unsigned long done;
+    uint32_t *ramp;             // ns per step while accelerating
+    unsigned long ramp_len;
+    uint32_t cruise;            // ns per step at full speed
+    unsigned long long deadline;
+    struct stepper *next;
+};
+static struct stepper *stepper_list = NULL;
+
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t work_cond;    // new move or stop - wakes the thread
+static pthread_cond_t done_cond;    // a move finished - wakes stepper_wait()
+static pthread_once_t once = PTHREAD_ONCE_INIT;
+static pthread_t thread;
+static int thread_running = 0;
+
+static void init_conds(void)
+{
+    pthread_condattr_t attr;
+
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&work_cond, &attr);
+    pthread_cond_init(&done_cond, &attr);
+    pthread_condattr_destroy(&attr);
+}
+
+static struct timespec to_timespec(unsigned long long ns)
+{
+    struct timespec ts;
+
+    ts.tv_sec = ns / 1000000000ULL;
+    ts.tv_nsec = ns % 1000000000ULL;
+    return ts;
+}
+
+// length of step i of the current move - the ramp is mirrored for deceleration
+static uint32_t interval(struct stepper *s, unsigned long i)
+{
+    unsigned long k = i < s->total - 1 - i ? i : s->total - 1 - i;
+
+    return k < s->ramp_len ? s->ramp[k] : s->cruise;
+}
+
+static int uses_gpio(struct stepper *s, unsigned int gpio)
+{
+    return s->step == gpio || s->dir == gpio || s->enable == (int)gpio;
+}
+
+static void finish(struct stepper *s)
+{
+    s->moving = 0;
+    free(s->ramp);
+    s->ramp = NULL;
+    pthread_cond_broadcast(&done_cond);
+}
+
+static void *stepper_thread(void *threadarg)
+{
+    struct sched_param param;
+    struct stepper *s;
+    struct timespec ts;
+    unsigned long long earliest, now;
+    uint64_t mask;
+
+    // best effort - carry on at normal priority if not permitted
+    param.sched_priority = sched_get_priority_max(SCHED_FIFO);
+    pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+
+    pthread_mutex_lock(&lock);
+    while (thread_running) {
+        earliest = 0;
+        for (s = stepper_list; s != NULL; s = s->next)
+            if (s->moving && (earliest == 0 || s->deadline < earliest))
+                earliest = s->deadline;
+
+        if (earliest == 0) {
+            pthread_cond_wait(&work_cond, &lock);
+            continue;
+        }
+
+        now = monotonic_ns();
+        if (earliest > now + SLEEP_SLACK_NS) {
+            // a new move may arrive with an earlier deadline
+            ts = to_timespec(earliest - SLEEP_SLACK_NS);
+            pthread_cond_timedwait(&work_cond, &lock, &ts);
+            continue;
+        }
+        if (earliest > now) {
+            ts = to_timespec(earliest);
+            pthread_mutex_unlock(&lock);
+            while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) != 0)
+                ;
+            pthread_mutex_lock(&lock);
+        }
+
+        // one STEP pulse for every axis that is due, in a single pair of stores
+        now = monotonic_ns();
+        mask = 0;
+        for (s = stepper_list; s != NULL; s = s->next)
+            if (s->moving && s->deadline <= now)
+                mask |= 1ULL << s->step;
+        if (mask == 0)
+            continue;   // stopped while we slept
+        output_gpio_mask(mask, 0);
+        delay_ns(STEP_PULSE_NS);
+        output_gpio_mask(0, mask);
+
+        for (s = stepper_list; s != NULL; s = s->next) {
+            if (!(mask & (1ULL << s->step)) || !s->moving)
+                continue;
+            __atomic_add_fetch(&s->position, s->direction, __ATOMIC_SEQ_CST);
+            if (++s->done == s->total)
+                finish(s);
+            else
+                s->deadline += interval(s, s->done);
+        }
+    }
+    pthread_mutex_unlock(&lock);
+    pthread_exit(NULL);
+}
+
+// returns NULL if out of memory or the thread could not be started
+struct stepper *stepper_new(unsigned int step, unsigned int dir, int enable)
+{
+    struct stepper *s;
+
+    pthread_once(&once, init_conds);
+
+    if ((s = calloc(1, sizeof(struct stepper))) == NULL)
+        return NULL;
+    s->step = step;
+    s->dir = dir;
+    s->enable = enable;
+    s->speed = 1000.0;
+    s->accel = 1000.0;
+
+    pthread_mutex_lock(&lock);
+    if (!thread_running) {
+        thread_running = 1;
+        if (pthread_create(&thread, NULL, stepper_thread, NULL) != 0) {
+            thread_running = 0;
+            pthread_mutex_unlock(&lock);
+            free(s);
+            return NULL;
+        }
+    }
+    s->next = stepper_list;
+    stepper_list = s;
+    pthread_mutex_unlock(&lock);
+    return s;
+}
+
+void stepper_free(struct stepper *s)
+{
+    struct stepper **p;
+
+    pthread_mutex_lock(&lock);
+    for (p = &stepper_list; *p != NULL; p = &(*p)->next)
+        if (*p == s) {
+            *p = s->next;
+            break;
+        }
+    if (s->moving)
+        finish(s);
+    pthread_mutex_unlock(&lock);
+    free(s);
+}
+
+// takes effect from the next move
+void stepper_set_speed(struct stepper *s, double speed, double accel)
+{
+    pthread_mutex_lock(&lock);
+    s->speed = speed;
+    s->accel = accel;
+    pthread_mutex_unlock(&lock);
+}
+
+// exact step times for constant acceleration from standstill, until full speed
+// return values:
+// 0 - success
+// 2 - out of memory
+static int build_ramp(double speed, double accel, uint32_t cruise, uint32_t **ramp, unsigned long *len)
+{
+    unsigned long i, n;
+    double t;
+
+    *ramp = NULL;
+    *len = 0;
+    if (accel <= 0.0)
+        return 0;
+    n = (unsigned long)ceil(speed * speed / (2.0 * accel));
+    if (n > MAX_RAMP)
+        n = MAX_RAMP;
+    if (n == 0)
+        return 0;
+    if ((*ramp = malloc(n * sizeof(uint32_t))) == NULL)
+        return 2;
+    for (i=0; i<n; i++) {
+        t = sqrt(2.0 / accel) * (sqrt(i + 1.0) - sqrt((double)i)) * 1e9;
+        if (t <= cruise)
+            break;
+        (*ramp)[i] = t > UINT32_MAX ? UINT32_MAX : (uint32_t)t;
+    }
+    *len = i;
+    return 0;
+}
+
+// start moves to absolute target positions on count axes at the same instant
+// the axis with the longest move sets the pace and the others are scaled so
+// that every axis starts and finishes together
+// return values:
+// 0 - success
+// 2 - out of memory
+int stepper_move(struct stepper **s, const long *target, int count)
+{
+    unsigned long steps[count];
+    uint32_t *ramp[count];
+    unsigned long ramp_len[count];
+    uint32_t cruise[count];
+    unsigned long longest = 0;
+    unsigned long long start;
+    double speed, accel, scale;
+    int lead = 0;
+    int i;
+
+    pthread_mutex_lock(&lock);
+    for (i=0; i<count; i++) {
+        if (s[i]->moving)
+            finish(s[i]);
+        steps[i] = labs(target[i] - __atomic_load_n(&s[i]->position, __ATOMIC_SEQ_CST));
+        if (steps[i] > longest) {
+            longest = steps[i];
+            lead = i;
+        }
+    }
+    speed = s[lead]->speed;
+    accel = s[lead]->accel;
+    pthread_mutex_unlock(&lock);
+
+    for (i=0; i<count; i++) {
+        ramp[i] = NULL;
+        ramp_len[i] = 0;
+        cruise[i] = 0;
+        if (steps[i] == 0)
+            continue;
+        scale = (double)steps[i] / longest;
+        cruise[i] = (uint32_t)(1e9 / (speed * scale));
+        if (build_ramp(speed * scale, accel * scale, cruise[i], &ramp[i], &ramp_len[i])) {
+            while (i--)
+                free(ramp[i]);
+            return 2;
+        }
+    }
+
+    // set DIR first so that it is stable before the first STEP edge
+    for (i=0; i<count; i++)
+        if (steps[i])
+            output_gpio(s[i]->dir, target[i] > stepper_position(s[i]));
+    delay_ns(DIR_SETUP_NS);
+
+    pthread_mutex_lock(&lock);
+    start = monotonic_ns();
+    for (i=0; i<count; i++) {
+        if (steps[i] == 0)
+            continue;
+        s[i]->direction = target[i] > stepper_position(s[i]) ? 1 : -1;
+        s[i]->total = steps[i];
+        s[i]->done = 0;
+        s[i]->ramp = ramp[i];
+        s[i]->ramp_len = ramp_len[i];
+        s[i]->cruise = cruise[i];
+        s[i]->deadline = start + interval(s[i], 0);
+        s[i]->moving = 1;
+    }
+    pthread_cond_signal(&work_cond);
+    pthread_mutex_unlock(&lock);
+    return 0;
+}
+
+// stop immediately
+void stepper_stop(struct stepper *s)
+{
+    pthread_mutex_lock(&lock);
+    if (s->moving)
+        finish(s);
+    pthread_mutex_unlock(&lock);
+}
+
+void stepper_stop_all(void)
+{
+    struct stepper *s;
+
+    pthread_mutex_lock(&lock);
+    for (s = stepper_list; s != NULL; s = s->next)
+        if (s->moving)
+            finish(s);
+    pthread_mutex_unlock(&lock);
+}
+
+// stop the move of any stepper using gpio for STEP, DIR or EN
+void stepper_stop_gpio(unsigned int gpio)
+{
+    struct stepper *s;
+
+    pthread_mutex_lock(&lock);
+    for (s = stepper_list; s != NULL; s = s->next)
+        if (s->moving && uses_gpio(s, gpio))
+            finish(s);
+    pthread_mutex_unlock(&lock);
+}
+
+// returns the stepper using gpio for STEP, DIR or EN, or NULL
+struct stepper *stepper_find(unsigned int gpio)
+{
+    struct stepper *s;
+
+    pthread_mutex_lock(&lock);
+    for (s = stepper_list; s != NULL; s = s->next)
+        if (uses_gpio(s, gpio))
+            break;
+    pthread_mutex_unlock(&lock);
+    return s;
+}
+
+void stepper_enable(struct stepper *s, int enabled)
+{
+    if (s->enable >= 0)
+        output_gpio(s->enable, !enabled);
+}
+
+long stepper_position(struct stepper *s)
+{
+    return __atomic_load_n(&s->position, __ATOMIC_SEQ_CST);
+}
+
+// return values:
+// 0 - success
+// 1 - the motor is moving
+int stepper_set_position(struct stepper *s, long position)
+{
+    int result = 1;
+
+    pthread_mutex_lock(&lock);
+    if (!s->moving) {
+        __atomic_store_n(&s->position, position, __ATOMIC_SEQ_CST);
+        result = 0;
+    }
+    pthread_mutex_unlock(&lock);
+    return result;
+}
+
+int stepper_moving(struct stepper *s)
+{
+    int moving;
+
+    pthread_mutex_lock(&lock);
+    moving = s->moving;
+    pthread_mutex_unlock(&lock);
+    return moving;
+}
+
+// wait up to timeout_ms (forever if negative) for the current move to finish
+// returns 1 if the motor is idle, 0 on timeout
+int stepper_wait(struct stepper *s, int timeout_ms)
+{
+    struct timespec ts = to_timespec(monotonic_ns() + timeout_ms * 1000000ULL);
+    int idle;
+
+    pthread_mutex_lock(&lock);
+    while (s->moving) {
+        if (timeout_ms < 0)
+            pthread_cond_wait(&done_cond, &lock);
+        else if (pthread_cond_timedwait(&done_cond, &lock, &ts) != 0)
+            break;
+    }
+    idle = !s->moving;
+    pthread_mutex_unlock(&lock);
+    return idle;
+}
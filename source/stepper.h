@@ -0,0 +1,39 @@
+/*
+Copyright (c) 2020 GC2
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+of the Software, and to permit persons to whom the Software is furnished to do
+so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/* Stepper motor (STEP/DIR) motion with trapezoidal acceleration */
+
+struct stepper;
+
+struct stepper *stepper_new(unsigned int step, unsigned int dir, int enable);
+void stepper_free(struct stepper *s);
+void stepper_set_speed(struct stepper *s, double speed, double accel);
+int stepper_move(struct stepper **s, const long *target, int count);
+void stepper_stop(struct stepper *s);
+void stepper_stop_all(void);
+void stepper_stop_gpio(unsigned int gpio);
+struct stepper *stepper_find(unsigned int gpio);
+void stepper_enable(struct stepper *s, int enabled);
+long stepper_position(struct stepper *s);
+int stepper_set_position(struct stepper *s, long position);
+int stepper_moving(struct stepper *s);
+int stepper_wait(struct stepper *s, int timeout_ms);
@@ -0,0 +1,91 @@
+/*
+Copyright (c) 2020 GC2
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+of the Software, and to permit persons to whom the Software is furnished to do
+so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <stdlib.h>
+#include "c_gpio.h"
+#include "ws2812.h"
+
+// timings in ns from the start of each bit cell
+#define T0H    350
+#define T1H    700
+#define TCELL  1250
+#define TRESET 300000   // newer parts latch after 280 us low
+
+// convert RGB buffers into per-cell pin masks so that the output loop
+// only has to do three masked stores per cell
+// order gives the index into each RGB triple of the byte sent first, second and third
+// returns NULL if out of memory
+struct ws2812_bit *ws2812_build(const struct ws2812_strip *strips, int count, const int order[3], size_t *nbits)
+{
+    struct ws2812_bit *stream;
+    size_t len = 0;
+    size_t i, b;
+    int s, bit;
+    unsigned char byte;
+    uint64_t mask;
+
+    for (s=0; s<count; s++)
+        if (strips[s].len > len)
+            len = strips[s].len;
+
+    *nbits = len * 8;
+    if ((stream = calloc(*nbits ? *nbits : 1, sizeof(struct ws2812_bit))) == NULL)
+        return NULL;
+
+    for (s=0; s<count; s++) {
+        mask = 1ULL << strips[s].gpio;
+        for (i=0; i<strips[s].len; i++) {
+            byte = strips[s].rgb[i - i%3 + order[i%3]];
+            for (bit=0; bit<8; bit++) {   // MSB first
+                b = i*8 + bit;
+                stream[b].high |= mask;
+                if (!(byte & (0x80 >> bit)))
+                    stream[b].zero |= mask;
+            }
+        }
+    }
+    return stream;
+}
+
+void ws2812_send(const struct ws2812_bit *stream, size_t nbits)
+{
+    unsigned long long start = monotonic_ns();
+    unsigned long long now;
+    size_t b;
+
+    for (b=0; b<nbits; b++) {
+        output_gpio_mask(stream[b].high, 0);
+        while (monotonic_ns() < start + T0H)
+            ;
+        output_gpio_mask(0, stream[b].zero);
+        while (monotonic_ns() < start + T1H)
+            ;
+        output_gpio_mask(0, stream[b].high);
+        start += TCELL;
+        if ((now = monotonic_ns()) > start)
+            start = now;    // overran the cell - don't squeeze the following ones
+        else
+            while (monotonic_ns() < start)
+                ;
+    }
+    delay_ns(TRESET);
+}
@@ -0,0 +1,43 @@
+/*
+Copyright (c) 2020 GC2
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+of the Software, and to permit persons to whom the Software is furnished to do
+so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/* WS2812 (NeoPixel) bit stream output */
+
+#include <stddef.h>
+#include <stdint.h>
+
+struct ws2812_strip
+{
+    unsigned int gpio;
+    const unsigned char *rgb;   // 3 bytes per LED
+    size_t len;                 // bytes
+};
+
+// one 1.25 us bit cell for every strip in parallel
+struct ws2812_bit
+{
+    uint64_t high;      // pins that carry a bit in this cell
+    uint64_t zero;      // pins whose bit is 0 (low after T0H)
+};
+
+struct ws2812_bit *ws2812_build(const struct ws2812_strip *strips, int count, const int order[3], size_t *nbits);
+void ws2812_send(const struct ws2812_bit *stream, size_t nbits);
@@ -0,0 +1,19 @@
+#!/usr/bin/python3
+import RPi.GPIO as GPIO
+from time import sleep
+
+trigger = 17
+echo = 27
+
+GPIO.setmode(GPIO.BCM)
+GPIO.setup(trigger, GPIO.OUT, initial=GPIO.LOW)
+GPIO.setup(echo, GPIO.IN)
+
+while True:
+  width = GPIO.trigger_and_measure(trigger, echo, timeout_us=30000)
+  if width is None:
+    print('No echo')
+  else:
+    # speed of sound 343 m/s, the echo travels there and back
+    print('Distance ', width * 343e-9 / 2, ' m')
+  sleep(2)
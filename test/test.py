@@ -53,6 +53,7 @@ SWITCH_PIN_BCM = 24
 LOOP_IN = 16
 LOOP_IN_BCM = 23
 LOOP_OUT = 22
+LOOP_OUT_BCM = 25
 NC_PIN = 24
 
 non_interactive = False
@@ -157,6 +158,27 @@ class TestAAASetup(unittest.TestCase):
         self.assertEqual(str(e.exception), 'The channel sent is invalid on a Raspberry Pi')
         GPIO.cleanup()
 
+        # test pull up/down on a list of channels
+        GPIO.setmode(GPIO.BOARD)
+        GPIO.setup([NC_PIN, LOOP_IN], GPIO.IN, pull_up_down=GPIO.PUD_UP)
+        time.sleep(0.001)
+        self.assertEqual(GPIO.input(NC_PIN), GPIO.HIGH)
+        self.assertEqual(GPIO.input(LOOP_IN), GPIO.HIGH)
+        GPIO.setup([NC_PIN, LOOP_IN], GPIO.IN, pull_up_down=GPIO.PUD_DOWN)
+        time.sleep(0.001)
+        self.assertEqual(GPIO.input(NC_PIN), GPIO.LOW)
+        self.assertEqual(GPIO.input(LOOP_IN), GPIO.LOW)
+        GPIO.cleanup()
+
+        # test initial value on a list of outputs
+        GPIO.setmode(GPIO.BOARD)
+        GPIO.setup(LOOP_IN, GPIO.IN)
+        GPIO.setup([LED_PIN, LOOP_OUT], GPIO.OUT, initial=GPIO.HIGH)
+        self.assertEqual(GPIO.input(LOOP_IN), GPIO.HIGH)
+        GPIO.setup([LED_PIN, LOOP_OUT], GPIO.OUT, initial=GPIO.LOW)
+        self.assertEqual(GPIO.input(LOOP_IN), GPIO.LOW)
+        GPIO.cleanup()
+
         # test setup of a tuple of channels
         GPIO.setmode(GPIO.BOARD)
         GPIO.setup( (LED_PIN, LOOP_OUT), GPIO.OUT)
@@ -721,6 +743,594 @@ class TestEdgeDetection(unittest.TestCase):
     def tearDown(self):
         GPIO.cleanup()
 
+class TestFrequency(unittest.TestCase):
+    def setUp(self):
+        GPIO.setmode(GPIO.BOARD)
+        GPIO.setup(LOOP_IN, GPIO.IN)
+        GPIO.setup(LOOP_OUT, GPIO.OUT)
+        self.pwm = GPIO.PWM(LOOP_OUT, 100)
+        self.pwm.start(25)
+
+    def test_measure_frequency(self):
+        result = GPIO.measure_frequency(LOOP_IN, 1000)
+        self.assertAlmostEqual(result['frequency'], 100, delta=5)
+        self.assertAlmostEqual(result['period_avg'], 10000, delta=500)
+        self.assertAlmostEqual(result['duty_cycle'], 25, delta=5)
+        self.assertTrue(result['period_min'] <= result['period_avg'] <= result['period_max'])
+        with self.assertRaises(ValueError):
+            GPIO.measure_frequency(LOOP_IN, 0)
+
+    def test_continuous(self):
+        GPIO.start_frequency(LOOP_IN)
+        time.sleep(0.5)
+        result = GPIO.read_frequency(LOOP_IN, reset=True)
+        self.assertAlmostEqual(result['frequency'], 100, delta=5)
+        with self.assertRaises(RuntimeError):
+            GPIO.measure_frequency(LOOP_IN, 100)
+        GPIO.stop_frequency(LOOP_IN)
+        with self.assertRaises(RuntimeError):
+            GPIO.read_frequency(LOOP_IN)
+
+    def test_event_detect_alongside(self):
+        # event detection can come and go while a measurement keeps running
+        GPIO.start_frequency(LOOP_IN)
+        GPIO.add_event_detect(LOOP_IN, GPIO.RISING)
+        time.sleep(0.1)
+        self.assertTrue(GPIO.event_detected(LOOP_IN))
+        GPIO.remove_event_detect(LOOP_IN)
+        GPIO.read_frequency(LOOP_IN, reset=True)
+        time.sleep(0.5)
+        self.assertAlmostEqual(GPIO.read_frequency(LOOP_IN)['frequency'], 100, delta=5)
+        GPIO.stop_frequency(LOOP_IN)
+
+    def test_single_edge_detection(self):
+        # the measurement still sees both edges, so the duty cycle is known
+        GPIO.add_event_detect(LOOP_IN, GPIO.RISING)
+        result = GPIO.measure_frequency(LOOP_IN, 1000)
+        self.assertAlmostEqual(result['duty_cycle'], 25, delta=5)
+        time.sleep(0.1)
+        self.assertTrue(GPIO.event_detected(LOOP_IN))
+
+    def tearDown(self):
+        self.pwm.stop()
+        GPIO.cleanup()
+
+class TestPulseIn(unittest.TestCase):
+    def setUp(self):
+        GPIO.setmode(GPIO.BOARD)
+        GPIO.setup(LOOP_IN, GPIO.IN)
+        GPIO.setup(LOOP_OUT, GPIO.OUT, initial=GPIO.LOW)
+
+    def test_pulse_in(self):
+        pwm = GPIO.PWM(LOOP_OUT, 100)
+        pwm.start(25)
+        width = GPIO.pulse_in(LOOP_IN, GPIO.HIGH)
+        pwm.stop()
+        self.assertAlmostEqual(width, 2500000, delta=300000)
+
+    def test_pulse_in_timeout(self):
+        self.assertEqual(GPIO.pulse_in(LOOP_IN, GPIO.HIGH, timeout_us=10000), None)
+        with self.assertRaises(ValueError):
+            GPIO.pulse_in(LOOP_IN, GPIO.HIGH, timeout_us=0)
+
+    def test_trigger_and_measure(self):
+        # the trigger pulse is over before measuring starts, so nothing answers on the loopback
+        self.assertEqual(GPIO.trigger_and_measure(LOOP_OUT, LOOP_IN, timeout_us=10000), None)
+        with self.assertRaises(RuntimeError):
+            GPIO.trigger_and_measure(LOOP_IN, LOOP_OUT)
+
+    def tearDown(self):
+        GPIO.cleanup()
+
+class TestEncoder(unittest.TestCase):
+    def setUp(self):
+        GPIO.setmode(GPIO.BOARD)
+
+    def test_not_setup(self):
+        with self.assertRaises(RuntimeError):
+            GPIO.Encoder(LOOP_IN, SWITCH_PIN)
+
+    def test_position(self):
+        GPIO.setup(LOOP_IN, GPIO.IN)
+        GPIO.setup(SWITCH_PIN, GPIO.IN, pull_up_down=GPIO.PUD_UP)
+        GPIO.setup(LOOP_OUT, GPIO.OUT, initial=GPIO.LOW)
+        encoder = GPIO.Encoder(LOOP_IN, SWITCH_PIN)
+        time.sleep(0.2)
+        # toggling A with B held steady only rocks between two positions
+        for i in range(10):
+            GPIO.output(LOOP_OUT, GPIO.HIGH)
+            time.sleep(0.01)
+            GPIO.output(LOOP_OUT, GPIO.LOW)
+            time.sleep(0.01)
+        self.assertEqual(encoder.position(), 0)
+        encoder.reset(100)
+        self.assertEqual(encoder.position(), 100)
+        encoder.stop()
+        with self.assertRaises(RuntimeError):
+            encoder.position()
+
+    def tearDown(self):
+        GPIO.cleanup()
+
+class TestDebounce(unittest.TestCase):
+    def setUp(self):
+        GPIO.setmode(GPIO.BOARD)
+        GPIO.setup(LOOP_IN, GPIO.IN)
+        GPIO.setup(LOOP_OUT, GPIO.OUT, initial=GPIO.LOW)
+        self.count = 0
+
+    def cb(self, chan):
+        self.count += 1
+
+    def test_bounce_filtered(self):
+        GPIO.add_event_detect(LOOP_IN, GPIO.BOTH, callback=self.cb, debounce=20000)
+        time.sleep(0.1)
+        self.assertEqual(GPIO.debounced_input(LOOP_IN), GPIO.LOW)
+        # a burst of bounces shorter than the debounce time settles high once
+        for i in range(5):
+            GPIO.output(LOOP_OUT, GPIO.HIGH)
+            GPIO.output(LOOP_OUT, GPIO.LOW)
+        GPIO.output(LOOP_OUT, GPIO.HIGH)
+        time.sleep(0.1)
+        self.assertEqual(self.count, 1)
+        self.assertEqual(GPIO.debounced_input(LOOP_IN), GPIO.HIGH)
+
+    def test_rising_pulses(self):
+        GPIO.add_event_detect(LOOP_IN, GPIO.RISING, callback=self.cb, debounce=20000)
+        time.sleep(0.1)
+        # the falling edges in between must settle too, or only the first pulse counts
+        for i in range(3):
+            GPIO.output(LOOP_OUT, GPIO.HIGH)
+            time.sleep(0.1)
+            GPIO.output(LOOP_OUT, GPIO.LOW)
+            time.sleep(0.1)
+        self.assertEqual(self.count, 3)
+        self.assertEqual(GPIO.debounced_input(LOOP_IN), GPIO.LOW)
+
+    def test_invalid(self):
+        with self.assertRaises(ValueError):
+            GPIO.add_event_detect(LOOP_IN, GPIO.RISING, debounce=0)
+        with self.assertRaises(ValueError):
+            GPIO.add_event_detect(LOOP_IN, GPIO.RISING, bouncetime=10, debounce=1000)
+        with self.assertRaises(RuntimeError):
+            GPIO.debounced_input(LOOP_IN)
+
+    def tearDown(self):
+        GPIO.cleanup()
+
+class TestSoftSPI(unittest.TestCase):
+    def setUp(self):
+        GPIO.setmode(GPIO.BOARD)
+
+    def test_loopback(self):
+        data = bytes(bytearray(range(256)))
+        for mode in range(4):
+            spi = GPIO.SoftSPI(LED_PIN, LOOP_OUT, LOOP_IN, None, mode=mode)
+            self.assertEqual(spi.transfer(data), data)
+        self.assertEqual(GPIO.gpio_function(LOOP_OUT), GPIO.OUT)
+        self.assertEqual(GPIO.gpio_function(LOOP_IN), GPIO.IN)
+        spi.write(b'\xff')
+        self.assertEqual(spi.read(2), b'\x00\x00')
+
+    def test_invalid(self):
+        with self.assertRaises(ValueError):
+            GPIO.SoftSPI(LED_PIN, LOOP_OUT, LOOP_IN, None, mode=4)
+        with self.assertRaises(ValueError):
+            GPIO.SoftSPI(LED_PIN, LOOP_OUT, LOOP_IN, None, speed=0)
+        with self.assertRaises(ValueError):
+            GPIO.SoftSPI(LED_PIN, LED_PIN, LOOP_IN, None)
+        with self.assertRaises(ValueError):
+            GPIO.SoftSPI(LED_PIN, LOOP_OUT, LOOP_IN, LOOP_OUT)
+
+    def tearDown(self):
+        GPIO.cleanup()
+
+class TestSoftI2C(unittest.TestCase):
+    def setUp(self):
+        GPIO.setmode(GPIO.BOARD)
+
+    def test_open_drain(self):
+        # lines are released (input with pull up) when idle
+        i2c = GPIO.SoftI2C(LOOP_IN, LED_PIN)
+        self.assertEqual(GPIO.gpio_function(LOOP_IN), GPIO.IN)
+        self.assertEqual(GPIO.gpio_function(LED_PIN), GPIO.IN)
+        self.assertEqual(GPIO.input(LOOP_IN), GPIO.HIGH)
+
+    def test_invalid(self):
+        with self.assertRaises(ValueError):
+            GPIO.SoftI2C(LOOP_IN, LOOP_IN)
+        with self.assertRaises(ValueError):
+            GPIO.SoftI2C(LOOP_IN, LED_PIN, freq=0)
+        i2c = GPIO.SoftI2C(LOOP_IN, LED_PIN)
+        with self.assertRaises(ValueError):
+            i2c.write(128, b'\x00')
+        with self.assertRaises(ValueError):
+            i2c.read(0x20, -1)
+
+    def tearDown(self):
+        GPIO.cleanup()
+
+class TestOneWire(unittest.TestCase):
+    def setUp(self):
+        GPIO.setmode(GPIO.BOARD)
+
+    def test_crc8(self):
+        self.assertEqual(GPIO.OneWire.crc8(b''), 0)
+        # DS18B20 ROM code with its CRC in the last byte
+        rom = b'\x28\xff\x64\x1e\x0f\x00\x00\x34'
+        self.assertEqual(GPIO.OneWire.crc8(rom[:7]), 0x34)
+        self.assertEqual(GPIO.OneWire.crc8(rom), 0)
+
+    def test_no_device(self):
+        ow = GPIO.OneWire(LOOP_IN)
+        self.assertEqual(GPIO.gpio_function(LOOP_IN), GPIO.IN)
+        self.assertFalse(ow.reset())
+        self.assertEqual(ow.read_bit(), 1)
+        self.assertEqual(ow.read_byte(), 0xff)
+        self.assertEqual(ow.read(2), b'\xff\xff')
+        with self.assertRaises(ValueError):
+            ow.write_byte(256)
+
+    def tearDown(self):
+        GPIO.cleanup()
+
+class TestWS2812(unittest.TestCase):
+    def setUp(self):
+        GPIO.setmode(GPIO.BOARD)
+
+    def test_write(self):
+        GPIO.setup(LOOP_IN, GPIO.IN)
+        GPIO.setup(LOOP_OUT, GPIO.OUT)
+        GPIO.setup(LED_PIN, GPIO.OUT)
+        GPIO.ws2812_write(LOOP_OUT, b'\xff\x00\x80' * 8)
+        self.assertEqual(GPIO.input(LOOP_IN), GPIO.LOW)
+        GPIO.ws2812_write([LOOP_OUT, LED_PIN], [b'\x01\x02\x03', b''], order='RGB')
+        self.assertEqual(GPIO.input(LOOP_IN), GPIO.LOW)
+
+    def test_invalid(self):
+        GPIO.setup(LOOP_OUT, GPIO.OUT)
+        with self.assertRaises(ValueError):
+            GPIO.ws2812_write(LOOP_OUT, b'\x00\x00\x00\x00')
+        with self.assertRaises(ValueError):
+            GPIO.ws2812_write(LOOP_OUT, b'\x00\x00\x00', order='RGR')
+        with self.assertRaises(RuntimeError):
+            GPIO.ws2812_write([LOOP_OUT, LED_PIN], [b'\x00\x00\x00'])
+        with self.assertRaises(RuntimeError):
+            GPIO.ws2812_write(LED_PIN, b'\x00\x00\x00')
+
+    def tearDown(self):
+        GPIO.cleanup()
+
+class TestDHT(unittest.TestCase):
+    def setUp(self):
+        GPIO.setmode(GPIO.BOARD)
+
+    def test_no_sensor(self):
+        with self.assertRaises(RuntimeError):
+            GPIO.read_dht(LOOP_IN, GPIO.DHT22)
+        self.assertEqual(GPIO.gpio_function(LOOP_IN), GPIO.IN)
+
+    def test_levels_followed(self):
+        # a 5 kHz square wave looks like a sensor sending all ones - every wait
+        # for HIGH and LOW has to succeed to get as far as the checksum
+        GPIO.setup(LOOP_OUT, GPIO.OUT)
+        pwm = GPIO.PWM(LOOP_OUT, 5000)
+        pwm.start(50)
+        try:
+            GPIO.read_dht(LOOP_IN, GPIO.DHT22)
+        except RuntimeError as e:
+            self.assertEqual(str(e), 'DHT sensor checksum error')
+        finally:
+            pwm.stop()
+
+    def test_invalid(self):
+        with self.assertRaises(ValueError):
+            GPIO.read_dht(LOOP_IN, 0)
+
+    def tearDown(self):
+        GPIO.cleanup()
+
+class TestBus(unittest.TestCase):
+    def setUp(self):
+        GPIO.setmode(GPIO.BOARD)
+
+    def test_loopback(self):
+        out_bus = GPIO.Bus([LED_PIN, LOOP_OUT], GPIO.OUT)
+        in_bus = GPIO.Bus((LOOP_IN,), GPIO.IN)
+        self.assertEqual(GPIO.gpio_function(LOOP_OUT), GPIO.OUT)
+        out_bus.write(0b10)
+        self.assertEqual(in_bus.read(), 1)
+        self.assertEqual(out_bus.read(), 0b10)
+        out_bus.write(0b01)
+        self.assertEqual(in_bus.read(), 0)
+        self.assertEqual(GPIO.input(LED_PIN), GPIO.HIGH)
+
+    def test_write_many(self):
+        GPIO.setup(LOOP_IN, GPIO.IN)
+        bus = GPIO.Bus([LOOP_OUT], GPIO.OUT)
+        GPIO.setup(LED_PIN, GPIO.OUT)
+        bus.write_many(b'\x00\x01' * 64, LED_PIN)
+        self.assertEqual(GPIO.input(LOOP_IN), GPIO.HIGH)
+        self.assertEqual(GPIO.input(LED_PIN), GPIO.LOW)
+        bus.write_many(b'\x01\x00', LED_PIN, setup_ns=40, pulse_ns=450)
+        self.assertEqual(GPIO.input(LOOP_IN), GPIO.LOW)
+        with self.assertRaises(ValueError):
+            bus.write_many(b'\x00', LED_PIN, pulse_ns=-1)
+        with self.assertRaises(ValueError):
+            bus.write_many(b'\x00', LOOP_OUT)
+
+    def test_invalid(self):
+        with self.assertRaises(ValueError):
+            GPIO.Bus([], GPIO.OUT)
+        with self.assertRaises(ValueError):
+            GPIO.Bus([LOOP_OUT, LOOP_OUT], GPIO.OUT)
+        bus = GPIO.Bus([LOOP_IN], GPIO.IN)
+        with self.assertRaises(RuntimeError):
+            bus.write(1)
+
+    def tearDown(self):
+        GPIO.cleanup()
+
+class TestKeypad(unittest.TestCase):
+    def setUp(self):
+        GPIO.setmode(GPIO.BOARD)
+
+    def test_loopback(self):
+        # LOOP_OUT as the only row and LOOP_IN as the only column, so the
+        # single key reads as held down whenever the row is scanned
+        keypad = GPIO.Keypad([LOOP_OUT], [LOOP_IN], interval_ms=1)
+        self.assertEqual(GPIO.gpio_function(LOOP_IN), GPIO.IN)
+        self.assertEqual(keypad.get_event(timeout=1), (0, 0, True))
+        self.assertTrue(keypad.is_pressed(0, 0))
+        self.assertEqual(keypad.get_event(timeout=0.05), None)
+        keypad.stop()
+        with self.assertRaises(RuntimeError):
+            keypad.get_event()
+
+    def test_cleanup_row(self):
+        keypad = GPIO.Keypad([LOOP_OUT], [LOOP_IN], interval_ms=1)
+        self.assertEqual(keypad.get_event(timeout=1), (0, 0, True))
+        GPIO.cleanup(LOOP_OUT)
+        with self.assertRaises(RuntimeError):
+            keypad.get_event(timeout=0.05)
+        self.assertEqual(GPIO.gpio_function(LOOP_OUT), GPIO.IN)
+
+    def test_invalid(self):
+        with self.assertRaises(ValueError):
+            GPIO.Keypad([], [LOOP_IN])
+        with self.assertRaises(ValueError):
+            GPIO.Keypad([LOOP_OUT], [LOOP_OUT])
+        with self.assertRaises(ValueError):
+            GPIO.Keypad([LOOP_OUT], [LOOP_IN], interval_ms=0)
+
+    def tearDown(self):
+        GPIO.cleanup()
+
+class TestStepper(unittest.TestCase):
+    def setUp(self):
+        GPIO.setmode(GPIO.BOARD)
+
+    def test_move(self):
+        # count the STEP pulses through the loopback
+        pulses = []
+        GPIO.setup(LOOP_IN, GPIO.IN)
+        GPIO.add_event_detect(LOOP_IN, GPIO.RISING, callback=pulses.append)
+        stepper = GPIO.Stepper(LOOP_OUT, LED_PIN, speed=2000, accel=4000)
+        stepper.move(200)
+        self.assertTrue(stepper.is_moving())
+        self.assertTrue(stepper.wait(timeout=2))
+        self.assertEqual(stepper.position(), 200)
+        self.assertEqual(GPIO.input(LED_PIN), GPIO.HIGH)
+        time.sleep(0.1)
+        self.assertEqual(len(pulses), 200)
+        stepper.move_to(-50)
+        self.assertTrue(stepper.wait(timeout=2))
+        self.assertEqual(stepper.position(), -50)
+        self.assertEqual(GPIO.input(LED_PIN), GPIO.LOW)
+        time.sleep(0.1)
+        self.assertEqual(len(pulses), 450)
+
+    def test_move_together(self):
+        x = GPIO.Stepper(LOOP_OUT, NC_PIN, speed=4000, accel=0)
+        y = GPIO.Stepper(LED_PIN, LOOP_IN, speed=4000, accel=0)
+        GPIO.Stepper.move_together([(x, 400), (y, 100)])
+        self.assertTrue(x.wait(timeout=2))
+        self.assertFalse(y.is_moving())
+        self.assertEqual((x.position(), y.position()), (400, 100))
+
+    def test_stop(self):
+        stepper = GPIO.Stepper(LOOP_OUT, LED_PIN, speed=100, accel=0)
+        stepper.move(1000)
+        self.assertFalse(stepper.wait(timeout=0.05))
+        with self.assertRaises(RuntimeError):
+            stepper.set_position(0)
+        stepper.stop()
+        self.assertFalse(stepper.is_moving())
+        position = stepper.position()
+        self.assertTrue(0 < position < 1000)
+        stepper.set_position(0)
+        self.assertEqual(stepper.position(), 0)
+
+    def test_cleanup_stops(self):
+        stepper = GPIO.Stepper(LOOP_OUT, LED_PIN, speed=100, accel=0)
+        stepper.move(1000)
+        time.sleep(0.05)
+        GPIO.cleanup(LED_PIN)
+        self.assertFalse(stepper.is_moving())
+        position = stepper.position()
+        time.sleep(0.05)
+        self.assertEqual(stepper.position(), position)
+
+    def test_invalid(self):
+        with self.assertRaises(ValueError):
+            GPIO.Stepper(LOOP_OUT, LOOP_OUT)
+        with self.assertRaises(ValueError):
+            GPIO.Stepper(LOOP_OUT, LED_PIN, speed=0)
+        stepper = GPIO.Stepper(LOOP_OUT, LED_PIN)
+        with self.assertRaises(ValueError):
+            GPIO.Stepper.move_together([(stepper, 1), (stepper, 2)])
+        with self.assertRaises(RuntimeError):
+            GPIO.Stepper(NC_PIN, LED_PIN)
+
+    def tearDown(self):
+        GPIO.cleanup()
+
+class TestServo(unittest.TestCase):
+    def setUp(self):
+        GPIO.setmode(GPIO.BOARD)
+
+    def test_pulses(self):
+        GPIO.setup(LOOP_IN, GPIO.IN)
+        GPIO.setup(LOOP_OUT, GPIO.OUT)
+        servo = GPIO.Servo(LOOP_OUT)
+        servo.start(1500)
+        width = GPIO.pulse_in(LOOP_IN, GPIO.HIGH, timeout_us=100000)
+        self.assertTrue(1400000 < width < 1600000)
+        servo.set_pulse_width(1000)
+        time.sleep(0.05)
+        width = GPIO.pulse_in(LOOP_IN, GPIO.HIGH, timeout_us=100000)
+        self.assertTrue(900000 < width < 1100000)
+        servo.stop()
+        time.sleep(0.05)
+        self.assertEqual(GPIO.pulse_in(LOOP_IN, GPIO.HIGH, timeout_us=50000), None)
+
+    def test_invalid(self):
+        GPIO.setup(LOOP_OUT, GPIO.OUT)
+        servo = GPIO.Servo(LOOP_OUT)
+        with self.assertRaises(ValueError):
+            servo.start(5000)
+        servo.start(1500)
+        with self.assertRaises(RuntimeError):
+            GPIO.Servo(LOOP_OUT)
+        with self.assertRaises(RuntimeError):
+            GPIO.PWM(LOOP_OUT, 50)
+        with self.assertRaises(RuntimeError):
+            GPIO.Servo(LED_PIN)
+
+    def test_other_object_keeps_pulses(self):
+        GPIO.setup(LOOP_IN, GPIO.IN)
+        GPIO.setup(LOOP_OUT, GPIO.OUT)
+        servo = GPIO.Servo(LOOP_OUT)
+        other = GPIO.Servo(LOOP_OUT)    # allowed while nothing is started
+        servo.start(1500)
+        other.stop()
+        del other
+        width = GPIO.pulse_in(LOOP_IN, GPIO.HIGH, timeout_us=100000)
+        self.assertTrue(1400000 < width < 1600000)
+
+    def tearDown(self):
+        GPIO.cleanup()
+
+class TestRecording(unittest.TestCase):
+    def setUp(self):
+        GPIO.setmode(GPIO.BOARD)
+        GPIO.setup(LOOP_IN, GPIO.IN)
+        GPIO.setup(LOOP_OUT, GPIO.OUT, initial=GPIO.LOW)
+        self.path = '/tmp/test_edges.log'
+
+    def test_record(self):
+        from RPi.GPIO import edgelog
+        GPIO.start_recording(self.path, LOOP_IN)
+        for i in range(5):
+            GPIO.output(LOOP_OUT, GPIO.HIGH)
+            time.sleep(0.01)
+            GPIO.output(LOOP_OUT, GPIO.LOW)
+            time.sleep(0.01)
+        GPIO.stop_recording()
+        log = edgelog.EdgeLog(self.path)
+        records = list(log)
+        self.assertEqual(len(records), 10)
+        self.assertEqual([r[1] for r in records], [LOOP_IN_BCM] * 10)
+        self.assertEqual([r[2] for r in records], [1, 0] * 5)
+        self.assertTrue(all(a[0] < b[0] for a, b in zip(records, records[1:])))
+
+    def test_wrap(self):
+        from RPi.GPIO import edgelog
+        GPIO.start_recording(self.path, [LOOP_IN], capacity=4)
+        for i in range(5):
+            GPIO.output(LOOP_OUT, GPIO.HIGH)
+            time.sleep(0.01)
+            GPIO.output(LOOP_OUT, GPIO.LOW)
+            time.sleep(0.01)
+        GPIO.stop_recording()
+        log = edgelog.EdgeLog(self.path)
+        self.assertEqual(log.lost, 6)
+        self.assertEqual([r[2] for r in log], [1, 0, 1, 0])
+
+    def test_invalid(self):
+        with self.assertRaises(RuntimeError):
+            GPIO.start_recording(self.path, LOOP_OUT)
+        with self.assertRaises((ValueError, OverflowError)):
+            GPIO.start_recording(self.path, LOOP_IN, capacity=2**62)
+        with self.assertRaises(ValueError):
+            GPIO.start_recording(self.path, LOOP_IN, capacity=0)
+        GPIO.start_recording(self.path, LOOP_IN)
+        with self.assertRaises(RuntimeError):
+            GPIO.start_recording(self.path, LOOP_IN)
+
+    def tearDown(self):
+        GPIO.cleanup()
+        if os.path.exists(self.path):
+            os.remove(self.path)
+
+class TestSnapshot(unittest.TestCase):
+    def setUp(self):
+        GPIO.setmode(GPIO.BOARD)
+
+    def test_restore(self):
+        GPIO.setup(LOOP_IN, GPIO.IN)
+        GPIO.setup(LOOP_OUT, GPIO.OUT, initial=GPIO.HIGH)
+        GPIO.setup(LED_PIN, GPIO.IN)
+        state = GPIO.snapshot()
+        GPIO.output(LOOP_OUT, GPIO.LOW)
+        GPIO.setup(LED_PIN, GPIO.OUT)
+        GPIO.restore(state)
+        self.assertEqual(GPIO.input(LOOP_IN), GPIO.HIGH)
+        self.assertEqual(GPIO.gpio_function(LED_PIN), GPIO.IN)
+        self.assertEqual(GPIO.gpio_function(LOOP_OUT), GPIO.OUT)
+        with self.assertRaises(RuntimeError):
+            GPIO.output(LED_PIN, GPIO.HIGH)
+        GPIO.output(LOOP_OUT, GPIO.LOW)
+
+    def test_invalid(self):
+        with self.assertRaises(ValueError):
+            GPIO.restore(b'')
+
+    def tearDown(self):
+        GPIO.cleanup()
+
+class TestSetDirectionMask(unittest.TestCase):
+    def setUp(self):
+        GPIO.setmode(GPIO.BOARD)
+        GPIO.setup(LOOP_IN, GPIO.IN, pull_up_down=GPIO.PUD_UP)
+        GPIO.setup(LOOP_OUT, GPIO.OUT, initial=GPIO.LOW)
+
+    def test_turnaround(self):
+        self.assertEqual(GPIO.input(LOOP_IN), GPIO.LOW)
+        GPIO.set_direction_mask(1 << LOOP_OUT_BCM, GPIO.IN)
+        self.assertEqual(GPIO.gpio_function(LOOP_OUT), GPIO.IN)
+        time.sleep(0.001)
+        self.assertEqual(GPIO.input(LOOP_IN), GPIO.HIGH)
+        with self.assertRaises(RuntimeError):
+            GPIO.output(LOOP_OUT, GPIO.HIGH)
+        GPIO.set_direction_mask(1 << LOOP_OUT_BCM | 1 << LOOP_IN_BCM, GPIO.OUT)
+        GPIO.set_direction_mask(1 << LOOP_IN_BCM, GPIO.IN)
+        self.assertEqual(GPIO.gpio_function(LOOP_OUT), GPIO.OUT)
+        self.assertEqual(GPIO.input(LOOP_IN), GPIO.LOW)
+        GPIO.output(LOOP_OUT, GPIO.HIGH)
+        self.assertEqual(GPIO.input(LOOP_IN), GPIO.HIGH)
+
+    def test_invalid(self):
+        with self.assertRaises(ValueError):
+            GPIO.set_direction_mask(1 << 54, GPIO.IN)
+        with self.assertRaises(ValueError):
+            GPIO.set_direction_mask(1 << LOOP_OUT_BCM, 5)
+        with self.assertRaises(RuntimeError):
+            GPIO.set_direction_mask(1 << LED_PIN_BCM, GPIO.OUT)
+
+    def tearDown(self):
+        GPIO.cleanup()
+
 class TestCleanup(unittest.TestCase):
     def setUp(self):
         GPIO.setmode(GPIO.BOARD)